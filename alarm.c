@@ -0,0 +1,56 @@
+/*
+ * ==========================================================================
+ * alarm.c - Buzzer alarm patterns, played by the TIM3 match output
+ * ==========================================================================
+ */
+
+#include <stdint.h>
+#include "hal.h"
+#include "alarm.h"
+#include "aq_prof.h"
+
+// Durations in ms: on, off, on, off, ... then 0, and the pattern repeats.
+// Every pattern has an even count so it always ends with the buzzer off.
+static const uint16_t alarm_poor[] = { 1000, 1000, 0 };
+static const uint16_t alarm_hazard[] = { 150, 150, 150, 150, 150, 1250, 0 };
+
+static const uint16_t *const alarm_patterns[ALARM_COUNT] = {
+    0, alarm_poor, alarm_hazard
+};
+
+static enum alarm_id alarm_current = ALARM_OFF;
+static const uint16_t *volatile alarm_pattern = 0;
+static volatile int alarm_step = 0;
+
+// TIM3 interrupt: the edge that starts the next step has just happened
+static void alarm_edge(void) {
+    const uint16_t *p = alarm_pattern;
+
+    if (!p) return;
+    AQ_PROF_BEGIN(AQ_PROF_ALARM_ISR);
+    if (p[++alarm_step] == 0) alarm_step = 0;
+    // The edge that ends an off step (odd) turns the buzzer on
+    hal_buzzer_edge((uint32_t)p[alarm_step] * 1000, alarm_step & 1);
+    AQ_PROF_END(AQ_PROF_ALARM_ISR);
+}
+
+void alarm_init(void) {
+    hal_buzzer_init(alarm_edge);
+    hal_buzzer_set(0);
+}
+
+int alarm_play(enum alarm_id id) {
+    const uint16_t *p;
+
+    if (id == alarm_current) return 0;
+    alarm_current = id;
+    p = alarm_patterns[id];
+
+    hal_irq_disable();
+    alarm_pattern = p;
+    alarm_step = 0;
+    hal_buzzer_set(p != 0);
+    if (p) hal_buzzer_edge((uint32_t)p[0] * 1000, 0);
+    hal_irq_enable();
+    return 1;
+}
@@ -0,0 +1,28 @@
+/*
+ * ==========================================================================
+ * alarm.h - Buzzer alarm patterns, played by the TIM3 match output
+ * ==========================================================================
+ * A pattern is a list of on/off durations. The match hardware makes every
+ * edge and the TIM3 interrupt queues the next one, so the cadence does not
+ * depend on how busy the main loop is. The main loop only posts an ID.
+ * ==========================================================================
+ */
+
+#ifndef ALARM_H
+#define ALARM_H
+
+enum alarm_id {
+    ALARM_OFF,
+    ALARM_POOR,         // 1 s on, 1 s off
+    ALARM_HAZARD,       // Three short beeps, then a pause
+    ALARM_COUNT
+};
+
+void alarm_init(void);
+
+// Start a pattern from its first beep. Posting the one already playing
+// does nothing, so it can be called on every reading. Returns 1 if the
+// buzzer changed pattern.
+int alarm_play(enum alarm_id id);
+
+#endif // ALARM_H
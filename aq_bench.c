@@ -0,0 +1,419 @@
+/*
+ * ==========================================================================
+ * aq_bench.c - Microbenchmarks for every scoring back-end
+ * ==========================================================================
+ * Runs each scorer over three feature distributions:
+ *   uniform  - independent random readings (worst case for branches)
+ *   walk     - slowly drifting readings, like the real 1 Hz sensor feed
+ *   recorded - a trace file of "co,aqi,temp,hum" lines as sent by the
+ *              Arduino (host only; pass the file name as argument)
+ *
+ * Results are written as CSV, one row per (back-end, distribution):
+ *   backend,distribution,samples,ns_per_sample,samples_per_sec,branch_misses_per_sample
+ * On the LPC1768 the last three columns are replaced by cycles_per_sample
+ * (DWT CYCCNT) and the rows are sent over UART0 at 115200 baud.
+ *
+ * Host build:
+ *     cc -O2 -o aq_bench aq_bench.c aq_score.c sensor_model_qs.c \
+ *        sensor_model_memo.c sensor_model_batch.c aq_state.c
+ *     ./aq_bench [trace.csv] > bench.csv
+ * Target build: compile the same files with AQ_BENCH_TARGET defined
+ * (add AQ_FIXED_POINT to benchmark the integer build).
+ *
+ * Forest features are ordered {co_ppm, temp, hum}.
+ * ==========================================================================
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "sensor_model.h"
+#include "sensor_model_nodes.h"
+#include "sensor_model_qs.h"
+#include "sensor_model_lut.h"
+#include "sensor_model_memo.h"
+#include "aq_score.h"
+#include "aq_state.h"
+
+#ifdef AQ_BENCH_TARGET
+#include <LPC17xx.h>
+#define BENCH_SAMPLES   256
+#define BENCH_REPEAT    4
+#else
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "sensor_model_batch.h"
+#define BENCH_SAMPLES   (1 << 20)
+#define BENCH_REPEAT    8
+#endif
+
+struct bench_sample {
+    int16_t co_ppm, aqi, temp, hum;
+};
+
+static struct bench_sample samples[BENCH_SAMPLES];
+static int n_samples;
+
+volatile float bench_sink_f;
+volatile aq_score_t bench_sink_s;
+
+// --- Deterministic generator, identical on host and target ---
+static uint32_t bench_rng = 0x2545F491u;
+
+static uint32_t bench_rand(void) {
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return bench_rng;
+}
+
+static void gen_uniform(void) {
+    int i;
+
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        samples[i].co_ppm = (int16_t)(bench_rand() % 120);
+        samples[i].aqi = (int16_t)(bench_rand() % 400);
+        samples[i].temp = (int16_t)(20 + bench_rand() % 20);
+        samples[i].hum = (int16_t)(50 + bench_rand() % 50);
+    }
+    n_samples = BENCH_SAMPLES;
+}
+
+static int16_t drift(int16_t v, int16_t lo, int16_t hi) {
+    v = (int16_t)(v + (int)(bench_rand() % 3) - 1);
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    return v;
+}
+
+static void gen_walk(void) {
+    struct bench_sample s = { 30, 120, 30, 80 };
+    int i;
+
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        s.co_ppm = drift(s.co_ppm, 0, 120);
+        s.aqi = drift(s.aqi, 0, 400);
+        if ((bench_rand() & 15) == 0) s.temp = drift(s.temp, 20, 40);
+        if ((bench_rand() & 15) == 0) s.hum = drift(s.hum, 50, 100);
+        samples[i] = s;
+    }
+    n_samples = BENCH_SAMPLES;
+}
+
+// --- Back-ends ---
+static void features_of(const struct bench_sample *s, int16_t *features) {
+    features[0] = s->co_ppm;
+    features[1] = s->temp;
+    features[2] = s->hum;
+}
+
+static void run_emlearn(void) {
+    int16_t f[SENSOR_MODEL_N_FEATURES];
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        features_of(&samples[i], f);
+        bench_sink_f = sensor_model_predict(f, SENSOR_MODEL_N_FEATURES);
+    }
+}
+
+static void run_nodes(void) {
+    int16_t f[SENSOR_MODEL_N_FEATURES];
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        features_of(&samples[i], f);
+        bench_sink_s = sensor_model_nodes_score(f);
+    }
+}
+
+static void run_qs(void) {
+    int16_t f[SENSOR_MODEL_N_FEATURES];
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        features_of(&samples[i], f);
+#ifdef AQ_FIXED_POINT
+        bench_sink_s = sensor_model_qs_score(f);
+#else
+        bench_sink_f = sensor_model_qs_predict(f, SENSOR_MODEL_N_FEATURES);
+#endif
+    }
+}
+
+static void run_lut(void) {
+    int16_t f[SENSOR_MODEL_N_FEATURES];
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        features_of(&samples[i], f);
+#ifdef AQ_FIXED_POINT
+        bench_sink_s = sensor_model_lut_score(f);
+#else
+        bench_sink_f = sensor_model_lut_predict(f, SENSOR_MODEL_N_FEATURES);
+#endif
+    }
+}
+
+static void run_memo(void) {
+    static struct sensor_model_memo memo;
+    int16_t f[SENSOR_MODEL_N_FEATURES];
+    int i;
+
+    sensor_model_memo_reset(&memo);
+    for (i = 0; i < n_samples; i++) {
+        features_of(&samples[i], f);
+        bench_sink_s = sensor_model_memo_score(&memo, f);
+    }
+}
+
+static void run_co_hazard(void) {
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        bench_sink_s = predict_co_hazard(samples[i].co_ppm, samples[i].temp, samples[i].hum);
+    }
+}
+
+static void run_aqi_hazard(void) {
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        bench_sink_s = predict_aqi_hazard(samples[i].aqi, samples[i].temp, samples[i].hum);
+    }
+}
+
+// --- State evaluator, fed with the linear scores of each sample ---
+static aq_score_t state_co[BENCH_SAMPLES];
+static aq_score_t state_aqi[BENCH_SAMPLES];
+static uint8_t states[BENCH_SAMPLES];
+
+// Scoring is done once per distribution, outside the timed region
+static void prepare_states(void) {
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        state_co[i] = predict_co_hazard(samples[i].co_ppm, samples[i].temp, samples[i].hum);
+        state_aqi[i] = predict_aqi_hazard(samples[i].aqi, samples[i].temp, samples[i].hum);
+    }
+}
+
+static void run_state_next(void) {
+    int i, state = GOOD;
+
+    for (i = 0; i < n_samples; i++) {
+        state = aq_state_next(state, state_co[i], state_aqi[i]);
+        states[i] = (uint8_t)state;
+    }
+    bench_sink_s = (aq_score_t)state;
+}
+
+static void run_state_trace(void) {
+    bench_sink_s = (aq_score_t)aq_state_trace(state_co, state_aqi, states, n_samples, GOOD);
+}
+
+#ifndef AQ_BENCH_TARGET
+static int16_t soa[SENSOR_MODEL_N_FEATURES][BENCH_SAMPLES];
+static float batch_out[BENCH_SAMPLES];
+
+// SoA conversion is done once per distribution, outside the timed region
+static void prepare_batch(void) {
+    int i;
+
+    for (i = 0; i < n_samples; i++) {
+        soa[0][i] = samples[i].co_ppm;
+        soa[1][i] = samples[i].temp;
+        soa[2][i] = samples[i].hum;
+    }
+}
+
+static void run_batch(void) {
+    const int16_t *const features[SENSOR_MODEL_N_FEATURES] = { soa[0], soa[1], soa[2] };
+
+    sensor_model_predict_batch(features, batch_out, n_samples);
+    bench_sink_f = batch_out[n_samples - 1];
+}
+#endif
+
+struct bench_backend {
+    const char *name;
+    void (*run)(void);
+};
+
+static const struct bench_backend backends[] = {
+    { "sensor_model_predict", run_emlearn },
+    { "sensor_model_nodes",   run_nodes },
+    { "sensor_model_qs",      run_qs },
+    { "sensor_model_lut",     run_lut },
+    { "sensor_model_memo",    run_memo },
+#ifndef AQ_BENCH_TARGET
+    { "sensor_model_batch",   run_batch },
+#endif
+    { "predict_co_hazard",    run_co_hazard },
+    { "predict_aqi_hazard",   run_aqi_hazard },
+    { "aq_state_next",        run_state_next },
+    { "aq_state_trace",       run_state_trace },
+};
+
+#define N_BACKENDS ((int)(sizeof(backends) / sizeof(backends[0])))
+
+#ifdef AQ_BENCH_TARGET
+
+// --- LPC1768: DWT cycle counter, results over UART0 ---
+static void bench_uart0_init(void) {
+    uint32_t pclk = SystemCoreClock / 4;
+    uint16_t divisor = pclk / (16 * 115200);
+
+    LPC_SC->PCONP |= (1 << 3);
+    LPC_PINCON->PINSEL0 |= (1 << 4) | (1 << 6);   // P0.2 = TXD0, P0.3 = RXD0
+    LPC_UART0->LCR = 0x83;
+    LPC_UART0->DLL = divisor & 0xFF;
+    LPC_UART0->DLM = (divisor >> 8) & 0xFF;
+    LPC_UART0->LCR = 0x03;
+    LPC_UART0->FCR = 0x07;
+}
+
+static void bench_puts(const char *s) {
+    while (*s) {
+        while (!(LPC_UART0->LSR & (1 << 5)));
+        LPC_UART0->THR = *s++;
+    }
+}
+
+static void bench_run(const char *distribution) {
+    char line[96];
+    int b, r;
+
+    prepare_states();
+    for (b = 0; b < N_BACKENDS; b++) {
+        uint32_t start, cycles;
+
+        backends[b].run();   // warm-up
+        start = DWT->CYCCNT;
+        for (r = 0; r < BENCH_REPEAT; r++) backends[b].run();
+        cycles = DWT->CYCCNT - start;
+        sprintf(line, "%s,%s,%d,%lu\r\n", backends[b].name, distribution,
+                n_samples * BENCH_REPEAT, (unsigned long)(cycles / (n_samples * BENCH_REPEAT)));
+        bench_puts(line);
+    }
+}
+
+int main(void) {
+    SystemInit();
+    SystemCoreClockUpdate();
+    bench_uart0_init();
+    sensor_model_qs_init();
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    bench_puts("backend,distribution,samples,cycles_per_sample\r\n");
+    gen_uniform();
+    bench_run("uniform");
+    gen_walk();
+    bench_run("walk");
+    bench_puts("done\r\n");
+
+    while (1);
+}
+
+#else
+
+// --- Host: monotonic clock and perf branch-miss counter ---
+static int perf_fd = -1;
+
+static void perf_open(void) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    perf_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_run(FILE *out, const char *distribution) {
+    int b, r;
+
+    prepare_batch();
+    prepare_states();
+    for (b = 0; b < N_BACKENDS; b++) {
+        long long misses = -1;
+        double start, ns;
+        double total = (double)n_samples * BENCH_REPEAT;
+
+        backends[b].run();   // warm-up
+        if (perf_fd >= 0) {
+            ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        start = now_ns();
+        for (r = 0; r < BENCH_REPEAT; r++) backends[b].run();
+        ns = now_ns() - start;
+        if (perf_fd >= 0) {
+            ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(perf_fd, &misses, sizeof(misses)) != sizeof(misses)) misses = -1;
+        }
+
+        fprintf(out, "%s,%s,%.0f,%.3f,%.0f,", backends[b].name, distribution,
+                total, ns / total, total / (ns * 1e-9));
+        if (misses >= 0) fprintf(out, "%.4f\n", misses / total);
+        else fprintf(out, "\n");
+    }
+}
+
+static int load_trace(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[64];
+    int co, aq, t, h;
+
+    if (!f) return 0;
+    n_samples = 0;
+    while (n_samples < BENCH_SAMPLES && fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%d,%d,%d,%d", &co, &aq, &t, &h) != 4) continue;
+        samples[n_samples].co_ppm = (int16_t)co;
+        samples[n_samples].aqi = (int16_t)aq;
+        samples[n_samples].temp = (int16_t)t;
+        samples[n_samples].hum = (int16_t)h;
+        n_samples++;
+    }
+    fclose(f);
+    return n_samples > 0;
+}
+
+int main(int argc, char **argv) {
+    FILE *out = stdout;
+
+    sensor_model_qs_init();
+    perf_open();
+    if (perf_fd < 0) fprintf(stderr, "perf counters unavailable, branch misses not reported\n");
+
+    fprintf(out, "backend,distribution,samples,ns_per_sample,samples_per_sec,branch_misses_per_sample\n");
+    gen_uniform();
+    bench_run(out, "uniform");
+    gen_walk();
+    bench_run(out, "walk");
+
+    if (argc > 1) {
+        if (load_trace(argv[1])) bench_run(out, "recorded");
+        else fprintf(stderr, "%s: no readings loaded\n", argv[1]);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * ==========================================================================
+ * aq_codec.c - Block codec for timestamped readings
+ * ==========================================================================
+ */
+
+#include "aq_codec.h"
+
+#define CHANNELS    5       // time, co_ppm, aqi, temp, hum
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t u) {
+    return (int32_t)((u >> 1) ^ (0u - (u & 1)));
+}
+
+static int bit_width(uint32_t u) {
+    int n = 0;
+
+    while (u) {
+        n++;
+        u >>= 1;
+    }
+    return n;
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// NULL if the varint runs past end or over 32 bits
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t x = 0;
+    int shift;
+
+    for (shift = 0; shift < 35; shift += 7) {
+        if (p >= end) return 0;
+        x |= (uint32_t)(*p & 0x7F) << shift;
+        if (!(*p++ & 0x80)) {
+            *v = x;
+            return p;
+        }
+    }
+    return 0;
+}
+
+// --- Encoder (32-bit only) ---
+struct bit_writer {
+    uint8_t *p;
+    uint32_t acc;
+    int n;                  // Bits held in acc, always < 8 between calls
+};
+
+static void put_bits(struct bit_writer *w, uint32_t v, int width) {
+    if (width > 16) {
+        put_bits(w, v & 0xFFFF, 16);
+        v >>= 16;
+        width -= 16;
+    }
+    w->acc |= v << w->n;
+    w->n += width;
+    while (w->n >= 8) {
+        *w->p++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->n -= 8;
+    }
+}
+
+// Zigzag deltas of sample i (i >= 1); v[0] is the time step change (i >= 2)
+static void sample_deltas(const struct aq_codec_encoder *e, int i, uint32_t v[CHANNELS]) {
+    const struct aq_reading *a = &e->reading[i - 1];
+    const struct aq_reading *b = &e->reading[i];
+
+    v[0] = 0;
+    if (i >= 2) {
+        v[0] = zigzag((int32_t)((e->time[i] - e->time[i - 1]) - (e->time[i - 1] - e->time[i - 2])));
+    }
+    v[1] = zigzag(b->co_ppm - a->co_ppm);
+    v[2] = zigzag(b->aqi - a->aqi);
+    v[3] = zigzag(b->temp - a->temp);
+    v[4] = zigzag(b->hum - a->hum);
+}
+
+static int encode_block(struct aq_codec_encoder *e, uint8_t *out) {
+    uint32_t v[CHANNELS], seen[CHANNELS] = { 0 };
+    uint8_t width[CHANNELS];
+    struct bit_writer w;
+    int i, c, len;
+
+    // Pass 1: the narrowest width that holds every value of each channel
+    for (i = 1; i < e->n; i++) {
+        sample_deltas(e, i, v);
+        for (c = 0; c < CHANNELS; c++) seen[c] |= v[c];
+    }
+    out[2] = e->n;
+    for (c = 0; c < CHANNELS; c++) {
+        width[c] = (uint8_t)bit_width(seen[c]);
+        out[3 + c] = width[c];
+    }
+
+    w.p = out + 8;
+    w.p = put_varint(w.p, e->time[0]);
+    w.p = put_varint(w.p, zigzag(e->reading[0].co_ppm));
+    w.p = put_varint(w.p, zigzag(e->reading[0].aqi));
+    w.p = put_varint(w.p, zigzag(e->reading[0].temp));
+    w.p = put_varint(w.p, zigzag(e->reading[0].hum));
+    if (e->n > 1) w.p = put_varint(w.p, e->time[1] - e->time[0]);
+
+    // Pass 2: pack
+    w.acc = 0;
+    w.n = 0;
+    for (i = 1; i < e->n; i++) {
+        sample_deltas(e, i, v);
+        for (c = (i >= 2) ? 0 : 1; c < CHANNELS; c++) put_bits(&w, v[c], width[c]);
+    }
+    if (w.n) *w.p++ = (uint8_t)w.acc;
+
+    len = (int)(w.p - out);
+    out[0] = (uint8_t)len;
+    out[1] = (uint8_t)(len >> 8);
+    e->n = 0;
+    return len;
+}
+
+void aq_codec_encoder_init(struct aq_codec_encoder *e) {
+    e->n = 0;
+}
+
+int aq_codec_encode(struct aq_codec_encoder *e, uint32_t time, const struct aq_reading *r,
+                    uint8_t *out) {
+    e->time[e->n] = time;
+    e->reading[e->n] = *r;
+    if (++e->n < AQ_CODEC_BLOCK) return 0;
+    return encode_block(e, out);
+}
+
+int aq_codec_encode_flush(struct aq_codec_encoder *e, uint8_t *out) {
+    return e->n ? encode_block(e, out) : 0;
+}
+
+// --- Decoder (host) ---
+int aq_codec_block_length(const uint8_t *in, int len) {
+    if (len < 8) return 0;
+    return in[0] | (in[1] << 8);
+}
+
+struct bit_reader {
+    const uint8_t *p, *end;
+    uint64_t acc;
+    int n;                  // Bits held in acc
+};
+
+static inline uint32_t get_bits(struct bit_reader *b, int width) {
+    uint32_t v;
+
+    if (b->n < width) {
+        while (b->n <= 56 && b->p < b->end) {
+            b->acc |= (uint64_t)*b->p++ << b->n;
+            b->n += 8;
+        }
+    }
+    v = (uint32_t)(b->acc & (((uint64_t)1 << width) - 1));
+    b->acc >>= width;
+    b->n -= width;
+    return v;
+}
+
+int aq_codec_decode(const uint8_t *in, int len, uint32_t *time, struct aq_reading *r) {
+    const uint8_t *end;
+    struct bit_reader b;
+    uint32_t base[CHANNELS], step = 0;
+    int32_t co, aqi, temp, hum;
+    int64_t bits;
+    int n, i;
+    int w0, w1, w2, w3, w4;
+
+    n = aq_codec_block_length(in, len);
+    if (n < 8 || n > len) return -1;
+    end = in + n;
+    n = in[2];
+    w0 = in[3];
+    w1 = in[4];
+    w2 = in[5];
+    w3 = in[6];
+    w4 = in[7];
+    if (n < 1 || n > AQ_CODEC_BLOCK || w0 > 32 || w1 > 17 || w2 > 17 || w3 > 17 || w4 > 17) return -1;
+
+    b.p = in + 8;
+    for (i = 0; i < CHANNELS; i++) {
+        if (!(b.p = get_varint(b.p, end, &base[i]))) return -1;
+    }
+    if (n > 1 && !(b.p = get_varint(b.p, end, &step))) return -1;
+
+    // Every field below is then known to lie inside the block
+    bits = (int64_t)(n - 1) * (w1 + w2 + w3 + w4) + (n > 2 ? (int64_t)(n - 2) * w0 : 0);
+    if (bits > (int64_t)(end - b.p) * 8) return -1;
+    b.end = end;
+    b.acc = 0;
+    b.n = 0;
+
+    time[0] = base[0];
+    co = unzigzag(base[1]);
+    aqi = unzigzag(base[2]);
+    temp = unzigzag(base[3]);
+    hum = unzigzag(base[4]);
+    for (i = 0; i < n; i++) {
+        if (i >= 1) {
+            if (i >= 2) step += (uint32_t)unzigzag(get_bits(&b, w0));
+            time[i] = time[i - 1] + step;
+            co += unzigzag(get_bits(&b, w1));
+            aqi += unzigzag(get_bits(&b, w2));
+            temp += unzigzag(get_bits(&b, w3));
+            hum += unzigzag(get_bits(&b, w4));
+        }
+        r[i].co_ppm = (int16_t)co;
+        r[i].aqi = (int16_t)aqi;
+        r[i].temp = (int16_t)temp;
+        r[i].hum = (int16_t)hum;
+    }
+    return n;
+}
@@ -0,0 +1,69 @@
+/*
+ * ==========================================================================
+ * aq_codec.h - Block codec for timestamped readings
+ * ==========================================================================
+ * Readings move slowly and arrive on a steady clock, so a block stores:
+ *   - the first sample in full (varints),
+ *   - the first time step, then each step's change (delta of delta,
+ *     zigzag): 0 bits per sample at a steady rate,
+ *   - each channel as zigzag deltas from the previous sample, bit-packed
+ *     at the narrowest width that fits the whole block.
+ *
+ * Block layout (little-endian):
+ *   0-1  LEN     block length in bytes, header included
+ *   2    N       samples, 1 .. AQ_CODEC_BLOCK
+ *   3-7  WIDTH   bits per value: time, co_ppm, aqi, temp, hum
+ *   8    base    varint time0; zigzag varints co_ppm, aqi, temp, hum of
+ *                sample 0; varint time step 1 (only if N > 1)
+ *   ..   packed  samples 1 .. N-1, LSB first: time (from sample 2 on),
+ *                then the four channel deltas
+ *
+ * Every block starts from absolute values, so a reader can skip to any
+ * block by its LEN and decode it alone.
+ *
+ * The encoder holds one block of samples (12 bytes each) and needs no
+ * 64-bit arithmetic; it runs on the LPC1768. The decoder is meant for the
+ * host and uses a 64-bit bit buffer.
+ * ==========================================================================
+ */
+
+#ifndef AQ_CODEC_H
+#define AQ_CODEC_H
+
+#include <stdint.h>
+#include "aq_parse.h"
+
+#ifndef AQ_CODEC_BLOCK
+#define AQ_CODEC_BLOCK      32      // Samples per block
+#endif
+
+typedef char aq_codec_block_range[(AQ_CODEC_BLOCK >= 2 && AQ_CODEC_BLOCK <= 255) ? 1 : -1];
+
+// Worst case: 30 header bytes, 17 bits per channel delta, 32 per time step
+#define AQ_CODEC_MAX_BLOCK  (30 + ((AQ_CODEC_BLOCK - 1) * 4 * 17 + (AQ_CODEC_BLOCK - 2) * 32 + 7) / 8)
+
+struct aq_codec_encoder {
+    uint32_t time[AQ_CODEC_BLOCK];
+    struct aq_reading reading[AQ_CODEC_BLOCK];
+    uint8_t n;
+};
+
+void aq_codec_encoder_init(struct aq_codec_encoder *e);
+
+// Add a sample. When it completes a block, the block is written to out
+// (AQ_CODEC_MAX_BLOCK bytes of room) and its length returned; else 0.
+int aq_codec_encode(struct aq_codec_encoder *e, uint32_t time, const struct aq_reading *r,
+                    uint8_t *out);
+
+// Write the samples still held as a short block; 0 if there are none
+int aq_codec_encode_flush(struct aq_codec_encoder *e, uint8_t *out);
+
+// LEN of the block at in, or 0 if fewer than len bytes hold a header
+int aq_codec_block_length(const uint8_t *in, int len);
+
+// Decode the block at in into time[] and r[] (AQ_CODEC_BLOCK entries of
+// room). Returns the number of samples, or -1 if the block is malformed
+// or longer than len.
+int aq_codec_decode(const uint8_t *in, int len, uint32_t *time, struct aq_reading *r);
+
+#endif // AQ_CODEC_H
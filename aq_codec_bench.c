@@ -0,0 +1,176 @@
+/*
+ * ==========================================================================
+ * aq_codec_bench.c - Compression ratio and speed of aq_codec on traces
+ * ==========================================================================
+ * Inputs, any number of each:
+ *   trace.csv      "co,aqi,temp,hum" lines as sent by the Arduino, taken
+ *                  as one per second ('#' lines and bad lines skipped)
+ *   -F flash.bin   an aq_log flash image (hal_sim.c -F), in record order
+ *                  with its own timestamps
+ *
+ * One CSV row per input:
+ *   input,samples,raw_bytes,text_bytes,coded_bytes,bits_per_sample,
+ *   ratio_raw,ratio_text,encode_ns_per_sample,decode_ns_per_sample
+ * raw_bytes counts a uint32 time plus struct aq_reading (12 bytes) per
+ * sample; text_bytes the text lines with their "\r\n". Every input is
+ * decoded again and compared; a mismatch is an error.
+ *
+ * Host build:
+ *     cc -O2 -o aq_codec_bench aq_codec_bench.c aq_codec.c
+ *     ./aq_codec_bench trace.csv [-F flash.bin] > codec.csv
+ * ==========================================================================
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "aq_codec.h"
+#include "aq_log.h"
+
+#define BENCH_MAX_SAMPLES   (1 << 20)
+#define BENCH_REPEAT        16
+
+static uint32_t times[BENCH_MAX_SAMPLES];
+static struct aq_reading readings[BENCH_MAX_SAMPLES];
+static int n_samples;
+static long text_bytes;
+
+static uint8_t coded[(BENCH_MAX_SAMPLES / AQ_CODEC_BLOCK + 1) * AQ_CODEC_MAX_BLOCK];
+static uint32_t out_times[BENCH_MAX_SAMPLES + AQ_CODEC_BLOCK];
+static struct aq_reading out_readings[BENCH_MAX_SAMPLES + AQ_CODEC_BLOCK];
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int load_csv(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[128];
+    int co, aq, t, h;
+    size_t len;
+
+    if (!f) return 0;
+    n_samples = 0;
+    text_bytes = 0;
+    while (n_samples < BENCH_MAX_SAMPLES && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || sscanf(line, "%d,%d,%d,%d", &co, &aq, &t, &h) != 4) continue;
+        len = strcspn(line, "\r\n");
+        text_bytes += (long)len + 2;
+        times[n_samples] = (uint32_t)n_samples;
+        readings[n_samples].co_ppm = (int16_t)co;
+        readings[n_samples].aqi = (int16_t)aq;
+        readings[n_samples].temp = (int16_t)t;
+        readings[n_samples].hum = (int16_t)h;
+        n_samples++;
+    }
+    fclose(f);
+    return n_samples > 0;
+}
+
+static int by_seq(const void *a, const void *b) {
+    uint32_t x = ((const struct aq_log_record *)a)->seq;
+    uint32_t y = ((const struct aq_log_record *)b)->seq;
+
+    return x < y ? -1 : x > y;
+}
+
+static int load_flash(const char *path) {
+    static struct aq_log_record recs[AQ_LOG_CAPACITY];
+    FILE *f = fopen(path, "rb");
+    size_t n, i;
+    char line[32];
+
+    if (!f) return 0;
+    n = fread(recs, sizeof(recs[0]), AQ_LOG_CAPACITY, f);
+    fclose(f);
+
+    n_samples = 0;
+    text_bytes = 0;
+    for (i = 0; i < n; i++) {
+        if (recs[i].seq != 0xFFFFFFFFu) recs[n_samples++] = recs[i];
+    }
+    qsort(recs, n_samples, sizeof(recs[0]), by_seq);
+    for (i = 0; i < (size_t)n_samples; i++) {
+        times[i] = recs[i].time_s;
+        readings[i].co_ppm = recs[i].co_ppm;
+        readings[i].aqi = recs[i].aqi;
+        readings[i].temp = recs[i].temp;
+        readings[i].hum = recs[i].hum;
+        text_bytes += sprintf(line, "%d,%d,%d,%d", recs[i].co_ppm, recs[i].aqi, recs[i].temp, recs[i].hum) + 2;
+    }
+    return n_samples > 0;
+}
+
+static long encode_all(void) {
+    struct aq_codec_encoder e;
+    long len = 0;
+    int i;
+
+    aq_codec_encoder_init(&e);
+    for (i = 0; i < n_samples; i++) len += aq_codec_encode(&e, times[i], &readings[i], coded + len);
+    len += aq_codec_encode_flush(&e, coded + len);
+    return len;
+}
+
+static int decode_all(long len) {
+    long pos = 0;
+    int n = 0, k;
+
+    while (pos < len) {
+        k = aq_codec_decode(coded + pos, (int)(len - pos), out_times + n, out_readings + n);
+        if (k < 0) return -1;
+        pos += aq_codec_block_length(coded + pos, (int)(len - pos));
+        n += k;
+    }
+    return n;
+}
+
+static int bench(FILE *out, const char *name) {
+    double start, enc_ns, dec_ns;
+    long len = 0;
+    int r, n = 0;
+
+    start = now_ns();
+    for (r = 0; r < BENCH_REPEAT; r++) len = encode_all();
+    enc_ns = (now_ns() - start) / ((double)n_samples * BENCH_REPEAT);
+
+    start = now_ns();
+    for (r = 0; r < BENCH_REPEAT; r++) n = decode_all(len);
+    dec_ns = (now_ns() - start) / ((double)n_samples * BENCH_REPEAT);
+
+    if (n != n_samples || memcmp(out_times, times, n * sizeof(times[0])) != 0 ||
+        memcmp(out_readings, readings, n * sizeof(readings[0])) != 0) {
+        fprintf(stderr, "%s: round trip mismatch\n", name);
+        return 1;
+    }
+    fprintf(out, "%s,%d,%ld,%ld,%ld,%.2f,%.2f,%.2f,%.2f,%.2f\n", name, n_samples,
+            (long)n_samples * 12, text_bytes, len, len * 8.0 / n_samples,
+            n_samples * 12.0 / len, (double)text_bytes / len, enc_ns, dec_ns);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    FILE *out = stdout;
+    int opt, err = 0;
+
+    printf("input,samples,raw_bytes,text_bytes,coded_bytes,bits_per_sample,"
+           "ratio_raw,ratio_text,encode_ns_per_sample,decode_ns_per_sample\n");
+    while (optind < argc) {
+        if ((opt = getopt(argc, argv, "+F:")) != -1) {
+            if (opt != 'F') return 1;
+            if (load_flash(optarg)) err |= bench(out, optarg);
+            else fprintf(stderr, "%s: no records\n", optarg);
+        } else {
+            if (load_csv(argv[optind])) err |= bench(out, argv[optind]);
+            else fprintf(stderr, "%s: no readings\n", argv[optind]);
+            optind++;
+        }
+    }
+    return err;
+}
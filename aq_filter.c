@@ -0,0 +1,167 @@
+/*
+ * ==========================================================================
+ * aq_filter.c - Streaming window statistics for one sensor reading
+ * ==========================================================================
+ */
+
+#include "aq_filter.h"
+
+#define W       AQ_FILTER_WINDOW
+#define HALF    (AQ_FILTER_WINDOW / 2)
+
+// --- Median heaps ---
+// Entry k: k < 0 max-heap (children 2k, 2k-1), k > 0 min-heap
+// (children 2k, 2k+1), k = 0 the median. Parent is k / 2 either way.
+#define ENTRY(f, k)     ((f)->heap[HALF + (k)])
+#define VALUE(f, k)     ((f)->ring[ENTRY(f, k)])
+// Heap sizes; never above HALF, which the clamp makes visible to the compiler
+#define MIN_COUNT(f)    ((f)->count < W ? ((f)->count - 1) / 2 : HALF)
+#define MAX_COUNT(f)    ((f)->count < W ? (f)->count / 2 : HALF)
+
+static void heap_swap(struct aq_filter *f, int i, int j) {
+    uint8_t t = ENTRY(f, i);
+
+    ENTRY(f, i) = ENTRY(f, j);
+    ENTRY(f, j) = t;
+    f->pos[ENTRY(f, i)] = (int8_t)i;
+    f->pos[ENTRY(f, j)] = (int8_t)j;
+}
+
+// Swap when entry i holds the smaller value; returns 1 if it did
+static int heap_order(struct aq_filter *f, int i, int j) {
+    if (VALUE(f, i) >= VALUE(f, j)) return 0;
+    heap_swap(f, i, j);
+    return 1;
+}
+
+// Sift down, starting at child i of the entry that moved. The median's
+// only children are -1 and 1; entry 1's sibling would be entry 2, its child.
+static void min_down(struct aq_filter *f, int i) {
+    int n = MIN_COUNT(f);
+
+    for (; i <= n; i *= 2) {
+        if (i > 1 && i < n && VALUE(f, i + 1) < VALUE(f, i)) i++;
+        if (!heap_order(f, i, i / 2)) break;
+    }
+}
+
+static void max_down(struct aq_filter *f, int i) {
+    int n = -MAX_COUNT(f);
+
+    for (; i >= n; i *= 2) {
+        if (i < -1 && i > n && VALUE(f, i) < VALUE(f, i - 1)) i--;
+        if (!heap_order(f, i / 2, i)) break;
+    }
+}
+
+// Sift up; returns 1 if the entry reached the median
+static int min_up(struct aq_filter *f, int i) {
+    while (i > 0 && heap_order(f, i, i / 2)) i /= 2;
+    return i == 0;
+}
+
+static int max_up(struct aq_filter *f, int i) {
+    while (i < 0 && heap_order(f, i / 2, i)) i /= 2;
+    return i == 0;
+}
+
+// ring[slot] changed from old (full window) or was just added
+static void median_update(struct aq_filter *f, int slot, int16_t old, int is_new) {
+    int16_t v = f->ring[slot];
+    int p = f->pos[slot];
+
+    if (p > 0) {
+        if (!is_new && old < v) min_down(f, p * 2);
+        else if (min_up(f, p)) max_down(f, -1);
+    } else if (p < 0) {
+        if (!is_new && v < old) max_down(f, p * 2);
+        else if (max_up(f, p)) min_down(f, 1);
+    } else {
+        if (MAX_COUNT(f)) max_down(f, -1);
+        if (MIN_COUNT(f)) min_down(f, 1);
+    }
+}
+
+// --- Min / max deques ---
+static void deque_push(uint8_t *q, uint8_t *head, uint8_t *len, const int16_t *ring,
+                       int slot, int keep_max) {
+    int16_t v = ring[slot];
+
+    // Drop samples that can no longer be the extreme
+    while (*len) {
+        int16_t back = ring[q[(*head + *len - 1) % W]];
+        if (keep_max ? back > v : back < v) break;
+        (*len)--;
+    }
+    q[(*head + *len) % W] = (uint8_t)slot;
+    (*len)++;
+}
+
+void aq_filter_init(struct aq_filter *f) {
+    int i;
+
+    f->next = 0;
+    f->count = 0;
+    f->sum = 0;
+    f->ewma = 0;
+    f->min_head = f->min_len = 0;
+    f->max_head = f->max_len = 0;
+    for (i = 0; i < W; i++) {
+        // Slot 0 is the median, then alternate: -1, +1, -2, +2, ...
+        f->ring[i] = 0;
+        f->pos[i] = (int8_t)(((i + 1) / 2) * ((i & 1) ? -1 : 1));
+        ENTRY(f, f->pos[i]) = (uint8_t)i;
+    }
+}
+
+void aq_filter_push(struct aq_filter *f, int16_t v) {
+    int slot = f->next;
+    int is_new = f->count < W;
+    int16_t old = f->ring[slot];
+
+    if (is_new) {
+        f->count++;
+        if (f->count == 1) f->ewma = (int32_t)v * 256;
+    } else {
+        // The sample in this slot leaves the window
+        f->sum -= old;
+        if (f->min_q[f->min_head] == slot) {
+            f->min_head = (uint8_t)((f->min_head + 1) % W);
+            f->min_len--;
+        }
+        if (f->max_q[f->max_head] == slot) {
+            f->max_head = (uint8_t)((f->max_head + 1) % W);
+            f->max_len--;
+        }
+    }
+
+    f->ring[slot] = v;
+    f->next = (uint8_t)((slot + 1) % W);
+    f->sum += v;
+    f->ewma += ((int32_t)v * 256 - f->ewma) >> AQ_FILTER_EWMA_SHIFT;
+    deque_push(f->min_q, &f->min_head, &f->min_len, f->ring, slot, 0);
+    deque_push(f->max_q, &f->max_head, &f->max_len, f->ring, slot, 1);
+    median_update(f, slot, old, is_new);
+}
+
+int16_t aq_filter_mean(const struct aq_filter *f) {
+    int32_t half = f->count / 2;
+
+    return (int16_t)((f->sum >= 0 ? f->sum + half : f->sum - half) / f->count);
+}
+
+int16_t aq_filter_ewma(const struct aq_filter *f) {
+    return (int16_t)((f->ewma + 128) >> 8);
+}
+
+int16_t aq_filter_min(const struct aq_filter *f) {
+    return f->ring[f->min_q[f->min_head]];
+}
+
+int16_t aq_filter_max(const struct aq_filter *f) {
+    return f->ring[f->max_q[f->max_head]];
+}
+
+int16_t aq_filter_median(const struct aq_filter *f) {
+    return f->ring[ENTRY(f, 0)];
+}
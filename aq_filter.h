@@ -0,0 +1,69 @@
+/*
+ * ==========================================================================
+ * aq_filter.h - Streaming window statistics for one sensor reading
+ * ==========================================================================
+ * Each push updates, over the last AQ_FILTER_WINDOW samples:
+ *   - moving average   running sum over the sample ring          O(1)
+ *   - EWMA             alpha = 1 / 2^AQ_FILTER_EWMA_SHIFT, Q8     O(1)
+ *   - min / max        monotonic deques of ring slots             O(1) amortised
+ *   - median           max-heap / min-heap pair around the median O(log w)
+ *
+ * Memory is fixed by the window size; nothing is recomputed from the
+ * whole window. Before the window fills, every statistic covers the
+ * samples seen so far (the median is then the upper middle sample when
+ * the count is even).
+ *
+ * The median uses one index heap: entries below 0 form the max-heap of
+ * the lower half, entries above 0 the min-heap of the upper half, and
+ * entry 0 is the median. pos[] finds a ring slot's heap entry, so the
+ * sample leaving the window is replaced in place and sifted, not searched.
+ * ==========================================================================
+ */
+
+#ifndef AQ_FILTER_H
+#define AQ_FILTER_H
+
+#include <stdint.h>
+
+#ifndef AQ_FILTER_WINDOW
+#define AQ_FILTER_WINDOW        5       // Samples (5 s at the 1 Hz feed)
+#endif
+#ifndef AQ_FILTER_EWMA_SHIFT
+#define AQ_FILTER_EWMA_SHIFT    2       // alpha = 1/4
+#endif
+
+// Odd, so the median is a sample; at least 3, so both heaps have an entry;
+// small enough for int8_t heap positions
+typedef char aq_filter_window_must_be_odd[(AQ_FILTER_WINDOW & 1) ? 1 : -1];
+typedef char aq_filter_window_too_small[(AQ_FILTER_WINDOW >= 3) ? 1 : -1];
+typedef char aq_filter_window_too_large[(AQ_FILTER_WINDOW <= 127) ? 1 : -1];
+
+struct aq_filter {
+    int16_t ring[AQ_FILTER_WINDOW];     // Last samples, oldest at `next`
+    uint8_t next;                       // Ring slot the next sample goes to
+    uint8_t count;                      // Samples in the window
+    int32_t sum;                        // Of ring[]
+    int32_t ewma;                       // Q8
+
+    // Monotonic deques of ring slots, oldest first; front = min / max
+    uint8_t min_q[AQ_FILTER_WINDOW];
+    uint8_t max_q[AQ_FILTER_WINDOW];
+    uint8_t min_head, min_len;
+    uint8_t max_head, max_len;
+
+    // Median heaps: heap[AQ_FILTER_WINDOW / 2 + k] is entry k
+    uint8_t heap[AQ_FILTER_WINDOW];     // Entry -> ring slot
+    int8_t pos[AQ_FILTER_WINDOW];       // Ring slot -> entry
+};
+
+void aq_filter_init(struct aq_filter *f);
+void aq_filter_push(struct aq_filter *f, int16_t v);
+
+// Valid once at least one sample has been pushed
+int16_t aq_filter_mean(const struct aq_filter *f);
+int16_t aq_filter_ewma(const struct aq_filter *f);
+int16_t aq_filter_min(const struct aq_filter *f);
+int16_t aq_filter_max(const struct aq_filter *f);
+int16_t aq_filter_median(const struct aq_filter *f);
+
+#endif // AQ_FILTER_H
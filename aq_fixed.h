@@ -0,0 +1,51 @@
+/*
+ * ==========================================================================
+ * aq_fixed.h - Score type for the air quality decision path
+ * ==========================================================================
+ * Build with AQ_FIXED_POINT defined to score in integers only (the LPC1768
+ * has no FPU, so float math is done by the soft-float library).
+ *
+ * Fixed-point scores are stored in hundredths (AQ_SCORE_SCALE = 100).
+ * All model weights, biases and thresholds are whole multiples of 0.01,
+ * so with integer inputs the fixed-point score is exact. A binary Q16
+ * format cannot hold 0.05/0.03/0.02 exactly and would misplace scores
+ * that land exactly on a threshold.
+ *
+ * Without AQ_FIXED_POINT the score type is plain float, as before.
+ * ==========================================================================
+ */
+
+#ifndef AQ_FIXED_H
+#define AQ_FIXED_H
+
+#include <stdint.h>
+
+#ifdef AQ_FIXED_POINT
+
+typedef int32_t aq_score_t;
+
+#define AQ_SCORE_SCALE  100
+
+// Constant conversion, folded by the compiler (no runtime float)
+#define AQ_SCORE(x)     ((aq_score_t)((x) * AQ_SCORE_SCALE + ((x) < 0 ? -0.5 : 0.5)))
+
+// Raw sensor inputs saturate here so weight products fit in 32 bits.
+// Any input this large already drives the score to its clamp.
+#define AQ_INPUT_LIMIT  10000
+// Round a score to the nearest integer (scores are never negative)
+#define AQ_SCORE_TO_INT(s)  (((s) + AQ_SCORE_SCALE / 2) / AQ_SCORE_SCALE)
+
+#define AQ_INPUT(v)     ((v) > AQ_INPUT_LIMIT ? AQ_INPUT_LIMIT : \
+                         (v) < -AQ_INPUT_LIMIT ? -AQ_INPUT_LIMIT : (v))
+
+#else
+
+typedef float aq_score_t;
+
+#define AQ_SCORE(x)     ((aq_score_t)(x))
+#define AQ_SCORE_TO_INT(s)  ((int)((s) + 0.5f))
+#define AQ_INPUT(v)     (v)
+
+#endif
+
+#endif // AQ_FIXED_H
@@ -0,0 +1,118 @@
+/*
+ * ==========================================================================
+ * aq_lat.c - Latency rings, percentiles and their text dump
+ * ==========================================================================
+ */
+
+#include "aq_lat.h"
+
+#if AQ_LAT
+
+#include "fmt.h"
+
+struct aq_lat_hop {
+    uint32_t ring[AQ_LAT_WINDOW];
+    uint32_t count;
+    uint32_t max;
+};
+
+static struct aq_lat_hop aq_lat_hops[AQ_LAT_N];
+static uint32_t aq_lat_last_capture;
+static uint8_t aq_lat_have_capture;
+
+static const char *const aq_lat_names[AQ_LAT_N] = {
+    "sample", "wire", "queue", "score", "display", "total", "alarm", "pacing"
+};
+
+void aq_lat_reset(void) {
+    int i;
+
+    for (i = 0; i < AQ_LAT_N; i++) {
+        aq_lat_hops[i].count = 0;
+        aq_lat_hops[i].max = 0;
+    }
+    aq_lat_have_capture = 0;
+}
+
+void aq_lat_init(void) {
+    aq_lat_reset();
+}
+
+void aq_lat_add(int hop, uint32_t us) {
+    struct aq_lat_hop *h = &aq_lat_hops[hop];
+
+    h->ring[h->count % AQ_LAT_WINDOW] = us;
+    h->count++;
+    if (us > h->max) h->max = us;
+}
+
+void aq_lat_reading(const struct aq_lat_stamp *s, uint32_t taken_us, uint32_t state_us,
+                    int alarm_changed) {
+    uint32_t capture = s->sent_us - (s->has_age ? (uint32_t)s->age_ms * 1000 : 0);
+
+    if (s->has_age) aq_lat_add(AQ_LAT_SAMPLE, (uint32_t)s->age_ms * 1000);
+    aq_lat_add(AQ_LAT_WIRE, s->decoded_us - s->sent_us);
+    aq_lat_add(AQ_LAT_QUEUE, taken_us - s->decoded_us);
+    aq_lat_add(AQ_LAT_SCORE, state_us - taken_us);
+    aq_lat_add(AQ_LAT_TOTAL, state_us - capture);
+    // The buzzer changes inside update_system_state(), with the state
+    if (alarm_changed) aq_lat_add(AQ_LAT_ALARM, state_us - capture);
+    if (aq_lat_have_capture) aq_lat_add(AQ_LAT_PACING, capture - aq_lat_last_capture);
+    aq_lat_last_capture = capture;
+    aq_lat_have_capture = 1;
+}
+
+static char *fmt_u32(char *p, uint32_t v) {
+    return fmt_dec_left(p, (int32_t)(v > INT32_MAX ? INT32_MAX : v), 1);
+}
+
+// Nearest-rank percentile of sorted v[0..n-1]
+static uint32_t percentile(const uint32_t *v, int n, int pct) {
+    int rank = (pct * n + 99) / 100;
+
+    return v[rank > 0 ? rank - 1 : 0];
+}
+
+int aq_lat_format(char *line, int n, uint32_t lost) {
+    static const uint8_t pcts[3] = { 50, 90, 99 };
+    uint32_t v[AQ_LAT_WINDOW], x;
+    const struct aq_lat_hop *h;
+    char *p = line;
+    int i, j, k, len;
+
+    if (n < 0 || n > AQ_LAT_N) return 0;
+    p = fmt_str(p, "LAT ");
+    if (n == 0) {
+        p = fmt_str(p, "unit=us window=");
+        p = fmt_u32(p, AQ_LAT_WINDOW);
+        p = fmt_str(p, " lost=");
+        p = fmt_u32(p, lost);
+    } else {
+        h = &aq_lat_hops[n - 1];
+        p = fmt_str(p, aq_lat_names[n - 1]);
+        p = fmt_str(p, " n=");
+        p = fmt_u32(p, h->count);
+        if (h->count) {
+            // Insertion sort of the window: at most AQ_LAT_WINDOW values
+            len = h->count < AQ_LAT_WINDOW ? (int)h->count : AQ_LAT_WINDOW;
+            for (i = 0; i < len; i++) {
+                x = h->ring[i];
+                for (j = i; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+                v[j] = x;
+            }
+            for (k = 0; k < 3; k++) {
+                p = fmt_str(p, " p");
+                p = fmt_u32(p, pcts[k]);
+                *p++ = '=';
+                p = fmt_u32(p, percentile(v, len, pcts[k]));
+            }
+            p = fmt_str(p, " max=");
+            p = fmt_u32(p, h->max);
+        }
+    }
+    p = fmt_str(p, "\r\n");
+    *p = '\0';
+    return (int)(p - line);
+}
+
+#endif // AQ_LAT
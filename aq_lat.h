@@ -0,0 +1,95 @@
+/*
+ * ==========================================================================
+ * aq_lat.h - Sample-to-alarm latency, hop by hop
+ * ==========================================================================
+ * Each reading is stamped where it passes a boundary, and every hop goes
+ * into its own ring of the last AQ_LAT_WINDOW values, for percentiles:
+ *
+ *   sample   Arduino: capture -> Serial.write; the age field of the
+ *            READING frame (link protocol version 2) or the age_ms field
+ *            of the text line (aq_parse.h), on its own clock
+ *   wire     Serial.write -> frame decoded in the UART1 ISR (the first
+ *            byte's ISR time, less one byte time, is the write)
+ *   queue    decoded -> task_readings takes it
+ *   score    taken -> state decided (filters, scores, state table)
+ *   display  state decided -> screen queued to the LCD
+ *   total    capture -> state decided
+ *   alarm    capture -> buzzer pattern changed, for the readings that
+ *            changed it
+ *   pacing   capture -> next capture (the Arduino's loop period): a gas
+ *            spike waits up to this long before it is sampled at all
+ *
+ * Times are hal_micros(): the board's 1 MHz TIM3 count, or the virtual
+ * clock in the simulator, where the breakdown is the same on every run
+ * (it models waits, flash erases and the wire, not instruction time;
+ * aq_prof.h measures that on the board).
+ *
+ * Four-field text lines from older sketches carry no age: for those
+ * "sample" gets nothing and the totals start at Serial.write. The median
+ * filter's lag, (AQ_FILTER_WINDOW - 1) / 2 readings on a step, comes on
+ * top of "alarm" and is not a hop.
+ *
+ * Build with -DAQ_LAT=1 (both sides of the link already agree on the
+ * frame). Without it the stamps and tables are not built. The dump, like
+ * aq_prof's, goes to the UART0 debug port:
+ *     LAT unit=us window=64 lost=0
+ *     LAT wire n=34 p50=14583 p90=14583 p99=14583 max=14583
+ * p50/p90/p99 are over the window, max over the whole run. lost counts
+ * readings missing from the Arduino's seq since the last reset.
+ * Readings queued while the splash screen is up are not measured.
+ * ==========================================================================
+ */
+
+#ifndef AQ_LAT_H
+#define AQ_LAT_H
+
+#include <stdint.h>
+
+#ifndef AQ_LAT
+#define AQ_LAT      0
+#endif
+
+// --- Hops ---
+#define AQ_LAT_SAMPLE   0
+#define AQ_LAT_WIRE     1
+#define AQ_LAT_QUEUE    2
+#define AQ_LAT_SCORE    3
+#define AQ_LAT_DISPLAY  4
+#define AQ_LAT_TOTAL    5
+#define AQ_LAT_ALARM    6
+#define AQ_LAT_PACING   7
+#define AQ_LAT_N        8
+
+#ifndef AQ_LAT_WINDOW
+#define AQ_LAT_WINDOW   64
+#endif
+
+// Longest line aq_lat_format() writes, with its "\r\n" and NUL
+#define AQ_LAT_LINE_MAX 96
+
+// Stamped by the UART1 ISR, carried with the frame (rx_queue.h)
+struct aq_lat_stamp {
+    uint32_t sent_us;       // Serial.write on the Arduino, LPC clock
+    uint32_t decoded_us;
+    uint16_t age_ms;        // Capture -> Serial.write
+    uint8_t has_age;        // 0 for a four-field text line
+};
+
+#if AQ_LAT
+
+void aq_lat_init(void);
+void aq_lat_reset(void);
+
+// All the hops of one reading, once its state is decided. Main loop only.
+void aq_lat_reading(const struct aq_lat_stamp *s, uint32_t taken_us, uint32_t state_us,
+                    int alarm_changed);
+void aq_lat_add(int hop, uint32_t us);
+
+// Line `line` of the dump into p, with "\r\n" and NUL: line 0 is the
+// header, with `lost` (readings missing from the seq since the last
+// reset), line 1 + i is hop i. Returns the length, 0 past the end.
+int aq_lat_format(char *p, int line, uint32_t lost);
+
+#endif // AQ_LAT
+
+#endif // AQ_LAT_H
@@ -0,0 +1,155 @@
+/*
+ * ==========================================================================
+ * aq_link.c - Binary framed link between the Arduino and the LPC1768
+ * ==========================================================================
+ * Plain C, no allocation and no stdio; builds for the LPC1768, the AVR
+ * and the host.
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "aq_link.h"
+
+// --- CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) ---
+// Byte at a time without a table: a few shifts per byte, no flash or
+// (on the AVR) RAM spent on a lookup table
+uint16_t aq_link_crc16(const uint8_t *data, int len) {
+    uint16_t crc = 0xFFFF;
+    uint8_t x;
+
+    while (len--) {
+        x = (crc >> 8) ^ *data++;
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+    }
+    return crc;
+}
+
+// --- Encoder ---
+int aq_link_encode(uint8_t *out, uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len) {
+    uint16_t crc;
+
+    if (len > AQ_LINK_MAX_PAYLOAD) return 0;
+    out[0] = AQ_LINK_SYNC;
+    out[1] = len;
+    out[2] = (AQ_LINK_VERSION << 4) | (type & 0x0F);
+    out[3] = seq;
+    memcpy(&out[AQ_LINK_HEADER], payload, len);
+    crc = aq_link_crc16(&out[1], AQ_LINK_HEADER - 1 + len);
+    out[AQ_LINK_HEADER + len] = crc >> 8;
+    out[AQ_LINK_HEADER + len + 1] = crc & 0xFF;
+    return AQ_LINK_OVERHEAD + len;
+}
+
+int aq_link_encode_reading(uint8_t *out, uint8_t seq, int16_t co_ppm, int16_t aqi, int8_t temp, uint8_t hum,
+                           uint16_t age_ms) {
+    uint8_t p[AQ_LINK_READING_LEN];
+
+    p[0] = (uint16_t)co_ppm & 0xFF;
+    p[1] = (uint16_t)co_ppm >> 8;
+    p[2] = (uint16_t)aqi & 0xFF;
+    p[3] = (uint16_t)aqi >> 8;
+    p[4] = (uint8_t)temp;
+    p[5] = hum;
+    p[6] = age_ms & 0xFF;
+    p[7] = age_ms >> 8;
+    return aq_link_encode(out, AQ_LINK_READING, seq, p, sizeof(p));
+}
+
+int aq_link_encode_baud(uint8_t *out, uint8_t type, uint8_t seq, uint32_t baud) {
+    uint8_t p[AQ_LINK_BAUD_LEN];
+
+    p[0] = baud & 0xFF;
+    p[1] = (baud >> 8) & 0xFF;
+    p[2] = (baud >> 16) & 0xFF;
+    p[3] = baud >> 24;
+    return aq_link_encode(out, type, seq, p, sizeof(p));
+}
+
+// --- Decoder ---
+void aq_link_decoder_init(struct aq_link_decoder *d) {
+    memset(d, 0, sizeof(*d));
+}
+
+// Drop the buffered SYNC and rescan what follows it for the next one
+static void aq_link_resync(struct aq_link_decoder *d) {
+    uint8_t i;
+
+    for (i = 1; i < d->pos && d->buf[i] != AQ_LINK_SYNC; i++);
+    d->bytes_skipped += i;
+    d->pos -= i;
+    memmove(d->buf, &d->buf[i], d->pos);
+}
+
+int aq_link_decode_byte(struct aq_link_decoder *d, uint8_t byte) {
+    uint8_t len;
+    uint16_t crc;
+
+    if (d->pos == 0 && byte != AQ_LINK_SYNC) {
+        d->bytes_skipped++;
+        return AQ_LINK_MORE;
+    }
+    d->buf[d->pos++] = byte;
+
+    // A resync can leave a complete frame (or garbage) in the buffer
+    while (d->pos >= 2) {
+        len = d->buf[1];
+        if (len > AQ_LINK_MAX_PAYLOAD) {
+            d->bad_headers++;
+            aq_link_resync(d);
+            continue;
+        }
+        if (d->pos < AQ_LINK_OVERHEAD + len) return AQ_LINK_MORE;
+
+        crc = ((uint16_t)d->buf[AQ_LINK_HEADER + len] << 8) | d->buf[AQ_LINK_HEADER + len + 1];
+        if (crc != aq_link_crc16(&d->buf[1], AQ_LINK_HEADER - 1 + len)) {
+            d->crc_errors++;
+            aq_link_resync(d);
+            continue;
+        }
+        d->pos = 0;
+        if ((d->buf[2] >> 4) != AQ_LINK_VERSION) {
+            d->bad_headers++;
+            return AQ_LINK_MORE;
+        }
+
+        d->type = d->buf[2] & 0x0F;
+        d->len = len;
+        d->payload = &d->buf[AQ_LINK_HEADER];
+        if (d->have_seq) d->frames_lost += (uint8_t)(d->buf[3] - d->seq - 1);
+        d->seq = d->buf[3];
+        d->have_seq = 1;
+        d->frames_ok++;
+        return AQ_LINK_FRAME;
+    }
+    return AQ_LINK_MORE;
+}
+
+int aq_link_get_reading(const struct aq_link_decoder *d, int16_t *co_ppm, int16_t *aqi, int16_t *temp, int16_t *hum) {
+    const uint8_t *p = d->payload;
+
+    if (d->type != AQ_LINK_READING || d->len != AQ_LINK_READING_LEN) return 0;
+    *co_ppm = (int16_t)(p[0] | ((uint16_t)p[1] << 8));
+    *aqi = (int16_t)(p[2] | ((uint16_t)p[3] << 8));
+    *temp = (int8_t)p[4];
+    *hum = p[5];
+    return 1;
+}
+
+uint16_t aq_link_get_age(const struct aq_link_decoder *d) {
+    const uint8_t *p = d->payload;
+
+    if (d->type != AQ_LINK_READING || d->len != AQ_LINK_READING_LEN) return 0;
+    return p[6] | ((uint16_t)p[7] << 8);
+}
+
+uint32_t aq_link_get_baud(const struct aq_link_decoder *d) {
+    const uint8_t *p = d->payload;
+
+    if (d->len != AQ_LINK_BAUD_LEN) return 0;
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int aq_link_baud_supported(uint32_t baud) {
+    return baud == 9600 || baud == 19200 || baud == 38400 || baud == 57600;
+}
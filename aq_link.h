@@ -0,0 +1,119 @@
+/*
+ * ==========================================================================
+ * aq_link.h - Binary framed link between the Arduino and the LPC1768
+ * ==========================================================================
+ * Frame:
+ *   0  SYNC      0xA5
+ *   1  LEN       payload length (0-AQ_LINK_MAX_PAYLOAD)
+ *   2  VER_TYPE  version (high nibble), frame type (low nibble)
+ *   3  SEQ       sequence number, +1 per frame sent
+ *   4  payload   LEN bytes, little-endian fields
+ *   .  CRC       CRC-16/CCITT-FALSE over bytes 1..3+LEN, high byte first
+ *
+ * Frame types:
+ *   READING    Arduino -> LPC  co_ppm int16, aqi int16, temp int8, hum uint8,
+ *                              age uint16: ms from capture to this frame
+ *   BAUD_REQ   Arduino -> LPC  baud uint32: ask to switch both ends
+ *   BAUD_ACK   LPC -> Arduino  baud uint32: switching now (0 = refused)
+ *   KEEPALIVE  LPC -> Arduino  sent at a negotiated baud; if either end
+ *                              hears nothing for AQ_LINK_TIMEOUT_MS it
+ *                              drops back to AQ_LINK_BASE_BAUD
+ *
+ * A reading is 14 bytes on the wire against 13-29, typically ~20, for
+ * the text line ("co,aqi,t,h,seq,age_ms\r\n").
+ * Version 2 added the age (aq_lat.h); version 1 frames count as bad
+ * headers, so both ends must be updated together.
+ * The decoder hunts for SYNC and checks LEN, CRC and version. After a
+ * bad frame it rescans from the byte after the false SYNC, so one
+ * corrupt byte costs at most the frame it hit. Corrupt frames are only
+ * counted; they are never passed on.
+ *
+ * Shared by arduino.cpp and code.c. AQ_LINK_PROTOCOL selects the binary
+ * link (1) or the text lines (0, default) and must match on both sides.
+ * ==========================================================================
+ */
+
+#ifndef AQ_LINK_H
+#define AQ_LINK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef AQ_LINK_PROTOCOL
+#define AQ_LINK_PROTOCOL        0
+#endif
+
+#define AQ_LINK_VERSION         2
+#define AQ_LINK_SYNC            0xA5
+#define AQ_LINK_HEADER          4       // SYNC, LEN, VER_TYPE, SEQ
+#define AQ_LINK_OVERHEAD        6       // Header + CRC
+#define AQ_LINK_MAX_PAYLOAD     8
+#define AQ_LINK_MAX_FRAME       (AQ_LINK_OVERHEAD + AQ_LINK_MAX_PAYLOAD)
+
+// --- Frame types ---
+#define AQ_LINK_READING         1
+#define AQ_LINK_BAUD_REQ        2
+#define AQ_LINK_BAUD_ACK        3
+#define AQ_LINK_KEEPALIVE       4
+
+#define AQ_LINK_READING_LEN     8
+#define AQ_LINK_BAUD_LEN        4
+
+// --- Baud negotiation ---
+#define AQ_LINK_BASE_BAUD       9600
+#define AQ_LINK_FAST_BAUD       57600   // <1% divisor error on both ends
+#define AQ_LINK_KEEPALIVE_MS    1000
+#define AQ_LINK_TIMEOUT_MS      5000
+#define AQ_LINK_RETRY_MS        30000
+
+// Result of aq_link_decode_byte()
+#define AQ_LINK_MORE            0
+#define AQ_LINK_FRAME           1
+
+struct aq_link_decoder {
+    uint8_t buf[AQ_LINK_MAX_FRAME];
+    uint8_t pos;
+
+    // Last good frame (valid after AQ_LINK_FRAME until the next byte)
+    uint8_t type;
+    uint8_t seq;
+    uint8_t len;
+    const uint8_t *payload;
+    uint8_t have_seq;
+
+    // Statistics
+    uint32_t frames_ok;
+    uint32_t frames_lost;       // Gaps in the sequence numbers
+    uint32_t crc_errors;
+    uint32_t bad_headers;       // LEN too large or unknown version
+    uint32_t bytes_skipped;     // Bytes discarded while hunting for SYNC
+};
+
+uint16_t aq_link_crc16(const uint8_t *data, int len);
+
+// --- Encoder ---
+// Each returns the frame length written to out (AQ_LINK_MAX_FRAME bytes)
+int aq_link_encode(uint8_t *out, uint8_t type, uint8_t seq, const uint8_t *payload, uint8_t len);
+int aq_link_encode_reading(uint8_t *out, uint8_t seq, int16_t co_ppm, int16_t aqi, int8_t temp, uint8_t hum,
+                           uint16_t age_ms);
+int aq_link_encode_baud(uint8_t *out, uint8_t type, uint8_t seq, uint32_t baud);
+
+// --- Decoder ---
+void aq_link_decoder_init(struct aq_link_decoder *d);
+int aq_link_decode_byte(struct aq_link_decoder *d, uint8_t byte);
+
+// Field access for the last good frame; 0 if the payload length is wrong
+int aq_link_get_reading(const struct aq_link_decoder *d, int16_t *co_ppm, int16_t *aqi, int16_t *temp, int16_t *hum);
+uint16_t aq_link_get_age(const struct aq_link_decoder *d);
+uint32_t aq_link_get_baud(const struct aq_link_decoder *d);
+
+int aq_link_baud_supported(uint32_t baud);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AQ_LINK_H
@@ -0,0 +1,219 @@
+/*
+ * ==========================================================================
+ * aq_log.c - Reading and state-change log in on-chip flash
+ * ==========================================================================
+ */
+
+#include "aq_log.h"
+
+#define ERASED              0xFFFFFFFFu
+#define PAGE_RECORDS        ((uint32_t)AQ_LOG_PAGE_RECORDS)
+#define SECTOR_RECORDS      ((uint32_t)AQ_LOG_SECTOR_RECORDS)
+#define SECTOR_PAGES        (SECTOR_RECORDS / PAGE_RECORDS)
+#define CAPACITY            ((uint32_t)AQ_LOG_CAPACITY)
+
+// --- Per-sector summary index ---
+struct aq_log_sector {
+    uint32_t first_seq;         // ERASED if the sector holds no records
+    uint32_t first_time;
+};
+
+static struct aq_log_sector sector_index[HAL_FLASH_LOG_SECTORS];
+
+// --- RAM pages: one filling, one waiting for aq_log_flush() ---
+static struct aq_log_record pages[2][AQ_LOG_PAGE_RECORDS];     // Word-aligned for IAP
+static int fill;                // Page being filled
+static uint32_t fill_count;
+static int pending;             // pages[fill ^ 1] is full and not yet programmed
+
+static uint32_t next_seq;       // Number of the next record
+static uint32_t flash_next;     // First record not yet in flash
+
+// --- Log time ---
+static uint32_t time_s, time_ms, time_last_ms;
+
+uint32_t aq_log_dropped = 0;
+
+static const struct aq_log_record *flash_record(uint32_t slot) {
+    return (const struct aq_log_record *)hal_flash_log_base() + slot;
+}
+
+static int sector_blank(int sector) {
+    const uint32_t *p = (const uint32_t *)flash_record(sector * SECTOR_RECORDS);
+    uint32_t i;
+
+    for (i = 0; i < HAL_FLASH_SECTOR_SIZE / 4; i++) {
+        if (p[i] != ERASED) return 0;
+    }
+    return 1;
+}
+
+void aq_log_init(void) {
+    const struct aq_log_record *r;
+    uint32_t lo, hi, mid;
+    int s, head = -1;
+
+    for (s = 0; s < HAL_FLASH_LOG_SECTORS; s++) {
+        r = flash_record(s * SECTOR_RECORDS);
+        sector_index[s].first_seq = r->seq;
+        sector_index[s].first_time = r->time_s;
+        if (r->seq != ERASED && (head < 0 || r->seq > sector_index[head].first_seq)) head = s;
+    }
+
+    next_seq = 0;
+    time_s = 0;
+    if (head >= 0) {
+        // Pages are programmed in order: find the last one in the head sector
+        lo = 1;
+        hi = SECTOR_PAGES;
+        while (lo < hi) {
+            mid = (lo + hi) / 2;
+            if (flash_record(head * SECTOR_RECORDS + mid * PAGE_RECORDS)->seq != ERASED) lo = mid + 1;
+            else hi = mid;
+        }
+        r = flash_record(head * SECTOR_RECORDS + lo * PAGE_RECORDS - 1);
+        next_seq = r->seq + 1;
+        time_s = r->time_s + 1;
+    }
+    flash_next = next_seq;
+    fill = 0;
+    fill_count = 0;
+    pending = 0;
+    time_ms = 0;
+    time_last_ms = hal_millis();
+}
+
+uint32_t aq_log_time(void) {
+    uint32_t now = hal_millis();
+
+    time_ms += now - time_last_ms;      // Wrap-safe
+    time_last_ms = now;
+    time_s += time_ms / 1000;
+    time_ms %= 1000;
+    return time_s;
+}
+
+int aq_log_append(int type, int state, int co_ppm, int aqi, int temp, int hum) {
+    struct aq_log_record *r;
+
+    if (fill_count == PAGE_RECORDS) {   // Both pages full
+        aq_log_dropped++;
+        return 1;
+    }
+    r = &pages[fill][fill_count++];
+    r->seq = next_seq++;
+    r->time_s = aq_log_time();
+    r->co_ppm = (int16_t)co_ppm;
+    r->aqi = (int16_t)aqi;
+    r->temp = (int8_t)temp;
+    r->hum = (uint8_t)hum;
+    r->type = (uint8_t)type;
+    r->state = (uint8_t)state;
+
+    if (fill_count < PAGE_RECORDS) return 0;
+    if (!pending) {
+        pending = 1;
+        fill ^= 1;
+        fill_count = 0;
+    }
+    return 1;
+}
+
+void aq_log_flush(void) {
+    const struct aq_log_record *page;
+    uint32_t slot;
+    int sector;
+
+    while (pending) {
+        page = pages[fill ^ 1];
+        slot = page[0].seq % CAPACITY;
+        sector = slot / SECTOR_RECORDS;
+
+        // Entering a sector: it gets the oldest records' place
+        if (slot % SECTOR_RECORDS == 0) {
+            sector_index[sector].first_seq = ERASED;
+            if (!sector_blank(sector)) hal_flash_erase(sector);
+            sector_index[sector].first_seq = page[0].seq;
+            sector_index[sector].first_time = page[0].time_s;
+        }
+        if (hal_flash_program(slot * sizeof(struct aq_log_record), page) != 0) {
+            aq_log_dropped += PAGE_RECORDS;
+        }
+        flash_next = page[0].seq + PAGE_RECORDS;
+
+        pending = 0;
+        if (fill_count == PAGE_RECORDS) {
+            pending = 1;
+            fill ^= 1;
+            fill_count = 0;
+        }
+    }
+}
+
+uint32_t aq_log_first(void) {
+    uint32_t first = flash_next;
+    int s;
+
+    for (s = 0; s < HAL_FLASH_LOG_SECTORS; s++) {
+        if (sector_index[s].first_seq != ERASED && sector_index[s].first_seq < first) {
+            first = sector_index[s].first_seq;
+        }
+    }
+    return first;
+}
+
+uint32_t aq_log_next(void) {
+    return next_seq;
+}
+
+int aq_log_read(uint32_t seq, struct aq_log_record *rec) {
+    uint32_t off;
+
+    if (seq >= next_seq) return 0;
+    if (seq >= flash_next) {
+        off = seq - flash_next;
+        if (pending) {
+            *rec = off < PAGE_RECORDS ? pages[fill ^ 1][off] : pages[fill][off - PAGE_RECORDS];
+        } else {
+            *rec = pages[fill][off];
+        }
+        return 1;
+    }
+    if (seq < aq_log_first()) return 0;
+    *rec = *flash_record(seq % CAPACITY);
+    return rec->seq == seq;     // A page lost to a failed program reads erased
+}
+
+uint32_t aq_log_seek(uint32_t time_s) {
+    struct aq_log_record rec;
+    uint32_t lo, hi, mid, best = ERASED;
+    int s;
+
+    // Sector with the latest start before time_s. Records can share a
+    // second across a sector boundary, so a sector starting at time_s may
+    // have records of that second at the end of the one before it
+    for (s = 0; s < HAL_FLASH_LOG_SECTORS; s++) {
+        if (sector_index[s].first_seq == ERASED || sector_index[s].first_time >= time_s) continue;
+        if (best == ERASED || sector_index[s].first_seq > best) best = sector_index[s].first_seq;
+    }
+
+    if (best == ERASED) {
+        lo = aq_log_first();
+        // Older than the whole log, or the log is still in RAM
+        if (lo < flash_next) return lo;
+    } else {
+        lo = best;
+    }
+
+    // First record at or after time_s in [lo, hi]; the sector after this
+    // one starts at or after time_s, so hi is an upper bound. Until that
+    // sector has been programmed its records are in RAM and not indexed
+    hi = lo - lo % SECTOR_RECORDS + SECTOR_RECORDS;
+    if (best == ERASED || hi >= flash_next) hi = next_seq;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (aq_log_read(mid, &rec) && rec.time_s < time_s) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
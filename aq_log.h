@@ -0,0 +1,80 @@
+/*
+ * ==========================================================================
+ * aq_log.h - Reading and state-change log in on-chip flash
+ * ==========================================================================
+ * Append-only circular log over the HAL flash log sectors. Records are
+ * 16 bytes and collect in a 256-byte RAM page; only full pages are
+ * programmed, by aq_log_flush() from a task, never from the reading path.
+ * The sectors are used in turn, so each is erased once per trip round the
+ * ring: 4 x 2048 records.
+ *
+ * Record number `seq` lives at slot seq % AQ_LOG_CAPACITY, so reading a
+ * record by number is direct. The index keeps, for each sector, the
+ * number and time of its first record; aq_log_seek() picks the sector
+ * from it and binary-searches inside, without scanning the log.
+ *
+ * Log time counts seconds the monitor has been running, carried over from
+ * the last record at start-up: power-off gaps are not counted, so time
+ * only goes up.
+ *
+ * Up to one page of records (the RAM page) is lost at power-off.
+ * ==========================================================================
+ */
+
+#ifndef AQ_LOG_H
+#define AQ_LOG_H
+
+#include <stdint.h>
+#include "hal.h"
+
+#define AQ_LOG_READING  1       // Periodic reading
+#define AQ_LOG_STATE    2       // State change, with the reading behind it
+
+struct aq_log_record {
+    uint32_t seq;               // 0xFFFFFFFF: erased, never written
+    uint32_t time_s;            // Log time, seconds
+    int16_t co_ppm;
+    int16_t aqi;
+    int8_t temp;
+    uint8_t hum;
+    uint8_t type;               // AQ_LOG_READING or AQ_LOG_STATE
+    uint8_t state;              // enum AirQualityState after this record
+};
+
+#define AQ_LOG_PAGE_RECORDS     (HAL_FLASH_PAGE_SIZE / sizeof(struct aq_log_record))
+#define AQ_LOG_SECTOR_RECORDS   (HAL_FLASH_SECTOR_SIZE / sizeof(struct aq_log_record))
+#define AQ_LOG_CAPACITY         (HAL_FLASH_LOG_SECTORS * AQ_LOG_SECTOR_RECORDS)
+
+typedef char aq_log_record_must_be_16_bytes[(sizeof(struct aq_log_record) == 16) ? 1 : -1];
+
+// Rebuilds the index from flash and continues after the last record
+void aq_log_init(void);
+
+// Queue a record (seq and time are filled in). Returns 1 when a page is
+// ready for aq_log_flush(). Records are dropped (aq_log_dropped) only if
+// both RAM pages are full.
+int aq_log_append(int type, int state, int co_ppm, int aqi, int temp, int hum);
+
+// Program the full page, erasing the next sector first when the ring
+// reaches it. Runs with interrupts off for up to ~100 ms (an erase, once
+// per 2048 records; a page program is ~1 ms). hal_millis() catches up
+// afterwards, but a buzzer step under way holds its level that much
+// longer: the alarm pattern slips once, by up to ~100 ms.
+void aq_log_flush(void);
+
+// Log time now, seconds
+uint32_t aq_log_time(void);
+
+// Oldest record still held, and the number the next record will get
+uint32_t aq_log_first(void);
+uint32_t aq_log_next(void);
+
+// First record at or after time_s (aq_log_next() if none)
+uint32_t aq_log_seek(uint32_t time_s);
+
+// Copy record seq, from flash or a RAM page; 0 if no longer held
+int aq_log_read(uint32_t seq, struct aq_log_record *rec);
+
+extern uint32_t aq_log_dropped;
+
+#endif // AQ_LOG_H
@@ -0,0 +1,104 @@
+/*
+ * ==========================================================================
+ * aq_model.c - Back-end selection for the hazard scores
+ * ==========================================================================
+ */
+
+#include <stdint.h>
+#include "aq_model.h"
+#include "aq_score.h"
+
+// Build messages quote the generated table sizes, so they follow the model
+#define AQ_MODEL_STR_(x)    #x
+#define AQ_MODEL_STR(x)     AQ_MODEL_STR_(x)
+
+#if AQ_MODEL_CO != AQ_BACKEND_LINEAR
+#error "AQ_MODEL_CO: only AQ_BACKEND_LINEAR is available (no forest is trained for CO)"
+#endif
+
+#if AQ_MODEL_AQI == AQ_BACKEND_LINEAR
+#pragma message("AQ_MODEL_AQI: linear (3 multiply-adds, no tables)")
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST
+#include "sensor_model_nodes.h"
+#pragma message("AQ_MODEL_AQI: forest, node walk (" AQ_MODEL_STR(SENSOR_MODEL_N_TREES) " trees, <= " \
+                AQ_MODEL_STR(SENSOR_MODEL_MAX_DEPTH) " compares each; " \
+                AQ_MODEL_STR(SENSOR_MODEL_N_NODES) " nodes, " AQ_MODEL_STR(SENSOR_MODEL_N_LEAVES) " leaves, " \
+                AQ_MODEL_STR(SENSOR_MODEL_NODES_BYTES) " bytes flash)")
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST_QS
+#include "sensor_model_qs.h"
+#pragma message("AQ_MODEL_AQI: forest, QuickScorer (" AQ_MODEL_STR(SENSOR_MODEL_N_FEATURES) " binary searches + " \
+                AQ_MODEL_STR(SENSOR_MODEL_N_FEATURES) "x" AQ_MODEL_STR(SENSOR_MODEL_N_TREES) \
+                " ANDs, constant time; " AQ_MODEL_STR(SENSOR_MODEL_NODES_BYTES) " bytes flash, masks for " \
+                AQ_MODEL_STR(SENSOR_MODEL_N_NODES) " nodes built in RAM)")
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST_LUT
+#include "sensor_model_lut.h"
+#pragma message("AQ_MODEL_AQI: forest, lookup table (a binary search per feature + 1 load; " \
+                AQ_MODEL_STR(SENSOR_MODEL_LUT_CELLS) " cells, " AQ_MODEL_STR(SENSOR_MODEL_LUT_VALUES) " values, " \
+                AQ_MODEL_STR(SENSOR_MODEL_LUT_BYTES) " bytes flash)")
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST_MEMO
+#include "sensor_model_memo.h"
+#pragma message("AQ_MODEL_AQI: forest, memoized (2x" AQ_MODEL_STR(SENSOR_MODEL_N_FEATURES) \
+                " compares while no feature changes bin, else a walk of the trees that test it; " \
+                AQ_MODEL_STR(SENSOR_MODEL_NODES_BYTES) " bytes flash + the LUT thresholds)")
+#else
+#error "AQ_MODEL_AQI: unknown back-end"
+#endif
+
+#pragma message("AQ_MODEL_CO: linear (3 multiply-adds, no tables)")
+
+#if AQ_MODEL_AQI == AQ_BACKEND_FOREST_MEMO
+static struct sensor_model_memo aqi_memo;
+#endif
+
+#if AQ_MODEL_AQI != AQ_BACKEND_LINEAR
+// Forest features are int16; saturate rather than wrap
+static int16_t forest_feature(int v) {
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+#endif
+
+void aq_model_init(void) {
+#if AQ_MODEL_AQI == AQ_BACKEND_FOREST_QS
+    sensor_model_qs_init();
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST_MEMO
+    sensor_model_memo_reset(&aqi_memo);
+#endif
+}
+
+aq_score_t aq_model_co_score(int co_ppm, int aqi_val, int temp_c, int hum_pct) {
+    (void)aqi_val;
+    return predict_co_hazard(co_ppm, temp_c, hum_pct);
+}
+
+aq_score_t aq_model_aqi_score(int co_ppm, int aqi_val, int temp_c, int hum_pct) {
+#if AQ_MODEL_AQI == AQ_BACKEND_LINEAR
+    (void)co_ppm;
+    return predict_aqi_hazard(aqi_val, temp_c, hum_pct);
+#else
+    int16_t features[3];
+    aq_score_t estimate;
+
+    (void)aqi_val;
+    features[0] = forest_feature(co_ppm);
+    features[1] = forest_feature(temp_c);
+    features[2] = forest_feature(hum_pct);
+
+#if AQ_MODEL_AQI == AQ_BACKEND_FOREST
+    estimate = sensor_model_nodes_score(features);
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST_QS
+    estimate = sensor_model_qs_score(features);
+#elif AQ_MODEL_AQI == AQ_BACKEND_FOREST_LUT
+#ifdef AQ_FIXED_POINT
+    estimate = sensor_model_lut_score(features);
+#else
+    estimate = sensor_model_lut_predict(features, 3);
+#endif
+#else
+    estimate = sensor_model_memo_score(&aqi_memo, features);
+#endif
+
+    return predict_aqi_hazard(AQ_SCORE_TO_INT(estimate), temp_c, hum_pct);
+#endif
+}
@@ -0,0 +1,55 @@
+/*
+ * ==========================================================================
+ * aq_model.h - Compile-time model registry for the hazard scores
+ * ==========================================================================
+ * Each output (CO hazard, AQI hazard) is scored by the back-end chosen at
+ * build time, e.g. -DAQ_MODEL_AQI=AQ_BACKEND_FOREST_LUT. The choice is
+ * resolved by the preprocessor inside aq_model.c: no function pointers,
+ * and only the selected back-end's code and tables are linked in.
+ *
+ * Back-ends:
+ *   AQ_BACKEND_LINEAR       predict_co_hazard / predict_aqi_hazard (aq_score.c)
+ *   AQ_BACKEND_FOREST       emlearn forest, node-array walk (sensor_model_nodes.h)
+ *   AQ_BACKEND_FOREST_QS    forest, QuickScorer bitvectors (sensor_model_qs.c)
+ *   AQ_BACKEND_FOREST_LUT   forest, partition lookup table (sensor_model_lut.h)
+ *   AQ_BACKEND_FOREST_MEMO  forest, memoized between readings (sensor_model_memo.c)
+ *
+ * The forest estimates AQI from {co_ppm, temp, hum}; the forest back-ends
+ * feed that estimate through the AQI scorer so the score keeps its 0-150
+ * scale and thresholds. There is no forest for CO.
+ *
+ * The selection is printed during the build (#pragma message), with its
+ * per-sample cost and table sizes taken from the generated headers. Each
+ * scorer is its own function, so its code size shows up in the map file.
+ * ==========================================================================
+ */
+
+#ifndef AQ_MODEL_H
+#define AQ_MODEL_H
+
+#include "aq_fixed.h"
+
+#define AQ_BACKEND_LINEAR       1
+#define AQ_BACKEND_FOREST       2
+#define AQ_BACKEND_FOREST_QS    3
+#define AQ_BACKEND_FOREST_LUT   4
+#define AQ_BACKEND_FOREST_MEMO  5
+
+#ifndef AQ_MODEL_CO
+#define AQ_MODEL_CO   AQ_BACKEND_LINEAR
+#endif
+
+#ifndef AQ_MODEL_AQI
+#define AQ_MODEL_AQI  AQ_BACKEND_LINEAR
+#endif
+
+// One-time set-up for back-ends that build tables at start-up
+void aq_model_init(void);
+
+// CO hazard score, 0-100
+aq_score_t aq_model_co_score(int co_ppm, int aqi_val, int temp_c, int hum_pct);
+
+// AQI hazard score, 0-150
+aq_score_t aq_model_aqi_score(int co_ppm, int aqi_val, int temp_c, int hum_pct);
+
+#endif // AQ_MODEL_H
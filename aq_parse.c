@@ -0,0 +1,120 @@
+/*
+ * ==========================================================================
+ * aq_parse.c - Streaming parser for the Arduino's text readings
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "aq_parse.h"
+
+// --- Formats ---
+const struct aq_parse_format aq_format_reading = {
+    6, 4, {
+        { 0, 10000, 1 },    // co_ppm; the MQ-7 pegs at rs = 0 (infinite ppm)
+        { 0, 500 },         // aqi (the Arduino clamps to 0-500)
+        { -40, 80 },        // temp, degC
+        { 0, 100 },         // hum, %
+        { 0, 255 },         // seq, wraps like the link's
+        { 0, 32767 }        // age_ms (the Arduino clamps)
+    }
+};
+
+const struct aq_parse_format aq_format_raw = {
+    2, 2, {
+        { 0, 1023 },        // MQ-7 ADC
+        { 0, 1023 }         // MQ-135 ADC
+    }
+};
+
+// Longest field accepted; more digits are out of every range anyway
+#define AQ_PARSE_MAX_DIGITS  6
+
+static void aq_parse_restart(struct aq_parser *p) {
+    p->field = 0;
+    p->digits = 0;
+    p->negative = 0;
+    p->bad = 0;
+    p->value = 0;
+}
+
+void aq_parse_init(struct aq_parser *p, const struct aq_parse_format *format) {
+    memset(p, 0, sizeof(*p));
+    p->format = format;
+}
+
+// Close the current field; returns 0 if it is empty or out of range
+static int aq_parse_end_field(struct aq_parser *p) {
+    const struct aq_field_range *r;
+    int32_t v = p->negative ? -p->value : p->value;
+
+    if (p->digits == 0 || p->field >= p->format->n_fields) return 0;
+    r = &p->format->range[p->field];
+    if (v > r->max && r->saturate) v = r->max;
+    if (v < r->min || v > r->max) return 0;
+    p->fields[p->field++] = (int16_t)v;
+    p->digits = 0;
+    p->negative = 0;
+    p->value = 0;
+    return 1;
+}
+
+int aq_parse_byte(struct aq_parser *p, char c) {
+    int ok;
+
+    if (c == '\n' || c == '\r') {
+        // Empty line (or the '\n' of "\r\n")
+        if (!p->bad && p->field == 0 && p->digits == 0 && !p->negative) return AQ_PARSE_MORE;
+
+        ok = !p->bad && aq_parse_end_field(p)
+             && (p->field == p->format->n_fields || p->field == p->format->min_fields);
+        if (ok) p->line_fields = p->field;
+        aq_parse_restart(p);
+        if (ok) {
+            p->lines_ok++;
+            return AQ_PARSE_OK;
+        }
+        p->lines_bad++;
+        return AQ_PARSE_ERROR;
+    }
+    if (p->bad) return AQ_PARSE_MORE;
+
+    if (c >= '0' && c <= '9') {
+        if (++p->digits > AQ_PARSE_MAX_DIGITS) p->bad = 1;
+        p->value = p->value * 10 + (c - '0');
+    } else if (c == ',') {
+        if (!aq_parse_end_field(p)) p->bad = 1;
+    } else if (c == '-' && p->digits == 0 && !p->negative) {
+        p->negative = 1;
+    } else if ((c == ' ' || c == '\t') && p->digits == 0 && !p->negative) {
+        // Leading blank
+    } else {
+        p->bad = 1;
+    }
+    return AQ_PARSE_MORE;
+}
+
+void aq_parse_reading(const struct aq_parser *p, struct aq_reading *out) {
+    uint8_t n = p->line_fields;
+
+    out->co_ppm = p->fields[0];
+    out->aqi = n > 1 ? p->fields[1] : 0;
+    out->temp = n > 2 ? p->fields[2] : 0;
+    out->hum = n > 3 ? p->fields[3] : 0;
+}
+
+int aq_parse_check(const struct aq_parse_format *format, struct aq_reading *r) {
+    int16_t *v[AQ_READING_FIELDS];
+    const struct aq_field_range *range;
+    uint8_t i;
+
+    v[0] = &r->co_ppm;
+    v[1] = &r->aqi;
+    v[2] = &r->temp;
+    v[3] = &r->hum;
+    for (i = 0; i < format->n_fields && i < AQ_READING_FIELDS; i++) {
+        range = &format->range[i];
+        if (*v[i] > range->max && range->saturate) *v[i] = range->max;
+        if (*v[i] < range->min || *v[i] > range->max) return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * ==========================================================================
+ * aq_parse.h - Streaming parser for the Arduino's text readings
+ * ==========================================================================
+ * Fed one byte at a time from UART1_IRQHandler. Digits are accumulated
+ * as they arrive, so nothing is buffered and no sscanf is needed.
+ *
+ * A line is comma-separated decimal integers ending in '\r' or '\n',
+ * e.g. "25,102,30,80,17,27\r\n": the format's min_fields required fields,
+ * optionally followed by all of its other fields. Each field may have
+ * leading blanks and a '-' sign. A line is rejected when it has any other
+ * number of fields, an empty field, any other character, or a value
+ * outside the field's range. A saturating field is the exception: above
+ * its range it reads as the maximum, so a pegged sensor still counts.
+ * Empty lines are ignored.
+ *
+ * Formats:
+ *   aq_format_reading - "co,aqi,temp,hum[,seq,age_ms]" (code.c); seq is
+ *                       +1 per line sent, age_ms the time from capture to
+ *                       Serial.print on the Arduino (aq_lat.h)
+ *   aq_format_raw     - "co_raw,aq_raw"   (old.c, MQ-7/MQ-135 readings;
+ *                       they land in co_ppm and aqi)
+ * ==========================================================================
+ */
+
+#ifndef AQ_PARSE_H
+#define AQ_PARSE_H
+
+#include <stdint.h>
+
+#define AQ_PARSE_MAX_FIELDS  6
+
+// Fields of a struct aq_reading, and the optional ones of aq_format_reading
+#define AQ_READING_FIELDS    4
+#define AQ_READING_SEQ       4
+#define AQ_READING_AGE_MS    5
+
+struct aq_reading {
+    int16_t co_ppm;
+    int16_t aqi;
+    int16_t temp;
+    int16_t hum;
+};
+
+struct aq_field_range {
+    int16_t min;
+    int16_t max;
+    uint8_t saturate;       // Above max reads as max instead of rejecting
+};
+
+struct aq_parse_format {
+    uint8_t n_fields;
+    uint8_t min_fields;     // Fields past this are optional, all or none
+    struct aq_field_range range[AQ_PARSE_MAX_FIELDS];
+};
+
+extern const struct aq_parse_format aq_format_reading;
+extern const struct aq_parse_format aq_format_raw;
+
+// Result of aq_parse_byte()
+#define AQ_PARSE_MORE   0   // Line not finished
+#define AQ_PARSE_OK     1   // Valid line, see aq_parse_reading()
+#define AQ_PARSE_ERROR  2   // Invalid line, discarded
+
+struct aq_parser {
+    const struct aq_parse_format *format;
+    uint8_t field;          // Index of the field being parsed
+    uint8_t digits;         // Digits seen in this field
+    uint8_t negative;
+    uint8_t bad;            // Line already rejected, skip to its end
+    int32_t value;
+    int16_t fields[AQ_PARSE_MAX_FIELDS];
+    uint8_t line_fields;    // Fields in the last valid line
+
+    // Statistics
+    uint32_t lines_ok;
+    uint32_t lines_bad;
+};
+
+void aq_parse_init(struct aq_parser *p, const struct aq_parse_format *format);
+
+int aq_parse_byte(struct aq_parser *p, char c);
+
+// Copy the last valid line out (fields it did not have read as 0)
+void aq_parse_reading(const struct aq_parser *p, struct aq_reading *out);
+
+// Range check of a reading that did not come through the parser (its
+// AQ_READING_FIELDS fields only). Saturating fields are clamped in place.
+int aq_parse_check(const struct aq_parse_format *format, struct aq_reading *r);
+
+#endif // AQ_PARSE_H
@@ -0,0 +1,43 @@
+/*
+ * ==========================================================================
+ * aq_pipeline.c - Reading -> filters -> hazard scores -> state
+ * ==========================================================================
+ */
+
+#include "aq_model.h"
+#include "aq_pipeline.h"
+#include "aq_prof.h"
+
+void aq_pipeline_init(struct aq_pipeline *p) {
+    aq_filter_init(&p->co);
+    aq_filter_init(&p->aqi);
+    p->state = GOOD;
+}
+
+void aq_pipeline_score(struct aq_pipeline *p, const struct aq_reading *r,
+                       aq_score_t *co_score, aq_score_t *aqi_score) {
+    int co, aqi;
+
+    AQ_PROF_BEGIN(AQ_PROF_SCORE);
+    // Median of the last AQ_FILTER_WINDOW readings: one-off spikes
+    // do not trip the alarm
+    aq_filter_push(&p->co, r->co_ppm);
+    aq_filter_push(&p->aqi, r->aqi);
+    co = aq_filter_median(&p->co);
+    aqi = aq_filter_median(&p->aqi);
+
+    // Back-ends chosen in aq_model.h
+    *co_score = aq_model_co_score(co, aqi, r->temp, r->hum);
+    *aqi_score = aq_model_aqi_score(co, aqi, r->temp, r->hum);
+    AQ_PROF_END(AQ_PROF_SCORE);
+}
+
+enum AirQualityState aq_pipeline_step(struct aq_pipeline *p, const struct aq_reading *r) {
+    aq_score_t co_score, aqi_score;
+
+    aq_pipeline_score(p, r, &co_score, &aqi_score);
+    AQ_PROF_BEGIN(AQ_PROF_STATE);
+    p->state = (enum AirQualityState)aq_state_next(p->state, co_score, aqi_score);
+    AQ_PROF_END(AQ_PROF_STATE);
+    return p->state;
+}
@@ -0,0 +1,41 @@
+/*
+ * ==========================================================================
+ * aq_pipeline.h - Reading -> filters -> hazard scores -> state
+ * ==========================================================================
+ * The decision steps of code.c as functions of an explicit state, with
+ * no globals and no hardware: code.c runs them on each valid reading, and
+ * aq_replay.c runs the same code over recorded traces on the host.
+ *
+ *   reading -> aq_filter medians (co_ppm, aqi)
+ *           -> aq_model_co_score / aq_model_aqi_score
+ *           -> aq_state_next
+ *
+ * The result depends only on the previous state and the last
+ * AQ_FILTER_WINDOW readings, which is what lets aq_replay split a trace.
+ * ==========================================================================
+ */
+
+#ifndef AQ_PIPELINE_H
+#define AQ_PIPELINE_H
+
+#include "aq_fixed.h"
+#include "aq_filter.h"
+#include "aq_parse.h"
+#include "aq_state.h"
+
+struct aq_pipeline {
+    struct aq_filter co;
+    struct aq_filter aqi;
+    enum AirQualityState state;
+};
+
+void aq_pipeline_init(struct aq_pipeline *p);
+
+// Push a reading through the filters and score it; the state is untouched
+void aq_pipeline_score(struct aq_pipeline *p, const struct aq_reading *r,
+                       aq_score_t *co_score, aq_score_t *aqi_score);
+
+// Score the reading and move to the next state, which is returned
+enum AirQualityState aq_pipeline_step(struct aq_pipeline *p, const struct aq_reading *r);
+
+#endif // AQ_PIPELINE_H
@@ -0,0 +1,94 @@
+/*
+ * ==========================================================================
+ * aq_prof.c - Per-stage timing tables and their text dump
+ * ==========================================================================
+ */
+
+#include "aq_prof.h"
+
+#if AQ_PROF
+
+#include "fmt.h"
+
+struct aq_prof_stage aq_prof_stages[AQ_PROF_N];
+uint32_t aq_prof_start[AQ_PROF_N];
+
+static uint32_t aq_prof_overhead;
+
+static const char *const aq_prof_names[AQ_PROF_N] = {
+    "rx_isr", "readings", "score", "state", "display", "lcd_isr", "alarm_isr", "log"
+};
+
+void aq_prof_reset(void) {
+    int i, k;
+
+    for (i = 0; i < AQ_PROF_N; i++) {
+        aq_prof_stages[i].count = 0;
+        aq_prof_stages[i].min = UINT32_MAX;
+        aq_prof_stages[i].max = 0;
+        aq_prof_stages[i].sum = 0;
+        for (k = 0; k < AQ_PROF_BUCKETS; k++) aq_prof_stages[i].hist[k] = 0;
+    }
+}
+
+void aq_prof_init(void) {
+    int i;
+
+    hal_cycles_init();
+    aq_prof_reset();
+
+    // Cost of an empty scope, through the same code as a real one
+    for (i = 0; i < 16; i++) {
+        AQ_PROF_BEGIN(AQ_PROF_STATE);
+        AQ_PROF_END(AQ_PROF_STATE);
+    }
+    aq_prof_overhead = aq_prof_stages[AQ_PROF_STATE].min;
+    aq_prof_reset();
+}
+
+static char *fmt_u32(char *p, uint32_t v) {
+    // fmt_dec is signed; counts and ticks stay below 2^31 in practice
+    return fmt_dec_left(p, (int32_t)(v > INT32_MAX ? INT32_MAX : v), 1);
+}
+
+int aq_prof_format(char *line, int n) {
+    const struct aq_prof_stage *s;
+    char *p = line;
+    int k;
+
+    if (n < 0 || n > AQ_PROF_N) return 0;
+    p = fmt_str(p, "PROF ");
+    if (n == 0) {
+        p = fmt_str(p, "unit=" HAL_CYCLES_UNIT);
+        p = fmt_str(p, " stages=");
+        p = fmt_u32(p, AQ_PROF_N);
+        p = fmt_str(p, " overhead=");
+        p = fmt_u32(p, aq_prof_overhead);
+    } else {
+        s = &aq_prof_stages[n - 1];
+        p = fmt_str(p, aq_prof_names[n - 1]);
+        p = fmt_str(p, " n=");
+        p = fmt_u32(p, s->count);
+        if (s->count) {
+            p = fmt_str(p, " min=");
+            p = fmt_u32(p, s->min);
+            p = fmt_str(p, " mean=");
+            p = fmt_u32(p, (uint32_t)(s->sum / s->count));     // Dump only: the divide is a library call
+            p = fmt_str(p, " max=");
+            p = fmt_u32(p, s->max);
+            p = fmt_str(p, " hist=");
+            for (k = 0; k < AQ_PROF_BUCKETS; k++) {
+                if (!s->hist[k]) continue;
+                if (p[-1] != '=') *p++ = ' ';
+                p = fmt_u32(p, (uint32_t)k);
+                *p++ = ':';
+                p = fmt_u32(p, s->hist[k]);
+            }
+        }
+    }
+    p = fmt_str(p, "\r\n");
+    *p = '\0';
+    return (int)(p - line);
+}
+
+#endif // AQ_PROF
@@ -0,0 +1,103 @@
+/*
+ * ==========================================================================
+ * aq_prof.h - Per-stage timing of the firmware, on the cycle counter
+ * ==========================================================================
+ * Bracket a stage with AQ_PROF_BEGIN(stage) / AQ_PROF_END(stage):
+ *
+ *     AQ_PROF_BEGIN(AQ_PROF_SCORE);
+ *     ... score the reading ...
+ *     AQ_PROF_END(AQ_PROF_SCORE);
+ *
+ * Each stage keeps count, min, max, sum and a log2 histogram in RAM
+ * (about 130 bytes). Ticks come from HAL_CYCLES(): core cycles from the
+ * DWT on the board, ns of the host clock in the simulator. A stage's
+ * time includes any interrupt that preempted it.
+ *
+ * BEGIN is one counter read and one store; END a read, a subtract and
+ * the update below, inline, about 20 cycles on the Cortex-M3 (the dump
+ * header reports the measured cost of an empty scope). Each stage must
+ * be entered from one context only (main loop or one ISR) and does not
+ * nest with itself: its start time is a single slot.
+ *
+ * Build with -DAQ_PROF=1. Without it (the default) the macros expand to
+ * nothing and no RAM or code is used.
+ *
+ * The table is dumped as text lines by aq_prof_format() (code.c sends
+ * them to the UART0 debug port on request):
+ *     PROF unit=cyc stages=8 overhead=21
+ *     PROF score n=120 min=310 mean=352 max=1204 hist=9:98 10:19 11:3
+ * hist is "k:count" for each non-empty bucket k: ticks in [2^(k-1), 2^k),
+ * bucket 0 for 0 ticks, the last bucket for everything above.
+ * ==========================================================================
+ */
+
+#ifndef AQ_PROF_H
+#define AQ_PROF_H
+
+#include <stdint.h>
+#include "hal.h"
+
+#ifndef AQ_PROF
+#define AQ_PROF     0
+#endif
+
+// --- Stages ---
+#define AQ_PROF_RX_ISR      0   // UART1 interrupt: bytes -> parsed frames
+#define AQ_PROF_READINGS    1   // task_readings, whole frame
+#define AQ_PROF_SCORE       2   // Filters and hazard scores (aq_pipeline)
+#define AQ_PROF_STATE       3   // State table lookup (aq_pipeline)
+#define AQ_PROF_DISPLAY     4   // Draw a screen, queue the changed cells
+#define AQ_PROF_LCD_ISR     5   // TIM1 interrupt: one LCD nibble
+#define AQ_PROF_ALARM_ISR   6   // TIM3 interrupt: next buzzer edge
+#define AQ_PROF_LOG         7   // Flash log page program / sector erase
+#define AQ_PROF_N           8
+
+#define AQ_PROF_BUCKETS     28  // Last bucket: 2^26 ticks and above
+
+// Longest line aq_prof_format() writes, with its "\r\n" and NUL
+#define AQ_PROF_LINE_MAX    (96 + AQ_PROF_BUCKETS * 15)
+
+#if AQ_PROF
+
+struct aq_prof_stage {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[AQ_PROF_BUCKETS];
+};
+
+extern struct aq_prof_stage aq_prof_stages[AQ_PROF_N];
+extern uint32_t aq_prof_start[AQ_PROF_N];
+
+static inline void aq_prof_add(int stage, uint32_t ticks) {
+    struct aq_prof_stage *s = &aq_prof_stages[stage];
+    // CLZ is one instruction on the Cortex-M3
+    int k = ticks ? 32 - __builtin_clz(ticks) : 0;
+
+    s->count++;
+    s->sum += ticks;
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+    s->hist[k < AQ_PROF_BUCKETS ? k : AQ_PROF_BUCKETS - 1]++;
+}
+
+#define AQ_PROF_BEGIN(stage)    (aq_prof_start[stage] = HAL_CYCLES())
+#define AQ_PROF_END(stage)      aq_prof_add((stage), HAL_CYCLES() - aq_prof_start[stage])
+
+// Starts the cycle counter, clears the table, measures an empty scope
+void aq_prof_init(void);
+void aq_prof_reset(void);
+
+// Line `line` of the dump into p, with "\r\n" and NUL: line 0 is the
+// header, line 1 + i is stage i. Returns the length, 0 past the end.
+int aq_prof_format(char *p, int line);
+
+#else
+
+#define AQ_PROF_BEGIN(stage)    ((void)0)
+#define AQ_PROF_END(stage)      ((void)0)
+
+#endif // AQ_PROF
+
+#endif // AQ_PROF_H
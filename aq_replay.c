@@ -0,0 +1,458 @@
+/*
+ * ==========================================================================
+ * aq_replay.c - Re-score recorded traces with the firmware's decision code
+ * ==========================================================================
+ * Runs every reading of a binary trace (aq_trace.h) through aq_pipeline,
+ * the code task_readings() runs on the board, and reports the states
+ * and the alarms they would have played.
+ *
+ *   aq_replay [-j threads] [-o timeline.csv] [-s] trace.bin
+ *   aq_replay -c trace.csv trace.bin       convert "co,aqi,temp,hum"
+ *                                          lines, one per second; lines
+ *                                          the firmware rejects are dropped
+ *   aq_replay -g samples [-S seed] trace.bin
+ *                                          write a random-walk trace
+ *   aq_replay -F flash.bin log.csv         dump a flash log image (aq_log.h,
+ *                                          aq_sim -F) and check aq_log_seek()
+ *
+ * The trace is mapped, not read, and split into one shard per thread:
+ *   pass 1  each shard primes its filters with the AQ_FILTER_WINDOW - 1
+ *           readings before it, scores its readings and stores one state
+ *           map per reading (aq_state_maps), 1 byte each, plus the
+ *           composed map of the whole shard
+ *   start   a shard's start state is GOOD run through the composed maps
+ *           of the shards before it: four lookups per shard
+ *   pass 2  each shard walks its maps from its start state, counting
+ *           samples per state and noting the transitions
+ * The filters only look back one window, and the state only at the last
+ * sample, so the result is the same as one pipeline over the whole trace
+ * for any thread count; -s runs that single pipeline to check it.
+ *
+ * Output, on stdout: per-state sample counts and entries, the alarm
+ * patterns started (alarm.h: entries into POOR and HAZARDOUS), and the
+ * throughput. -o writes the timeline, one "time_s,sample,state" line per
+ * state change.
+ *
+ * -F reads the image through aq_log.c (over hal_image.c) and writes one
+ * "seq,time_s,type,state,co,aqi,temp,hum" line per record. It then seeks
+ * every second from the first record's to one past the last and compares
+ * each result with a linear scan of the records.
+ *
+ * Host build (same AQ_MODEL_* flags as the firmware; -O3 vectorises
+ * aq_state_maps, see aq_state.c):
+ *     cc -O3 -pthread -o aq_replay aq_replay.c aq_trace.c aq_pipeline.c \
+ *        aq_filter.c aq_state.c aq_parse.c aq_model.c aq_score.c sensor_model_qs.c \
+ *        aq_log.c hal_image.c
+ * ==========================================================================
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "aq_log.h"
+#include "aq_model.h"
+#include "aq_pipeline.h"
+#include "aq_trace.h"
+#include "hal_image.h"
+
+// The memo back-end keeps its cache in one static for all callers
+#if AQ_MODEL_CO == AQ_BACKEND_FOREST_MEMO || AQ_MODEL_AQI == AQ_BACKEND_FOREST_MEMO
+#error "aq_replay: the memo back-end is not thread-safe; AQ_BACKEND_FOREST gives the same scores"
+#endif
+
+// The stage timings are one table for the whole program
+#if AQ_PROF
+#error "aq_replay: build without AQ_PROF"
+#endif
+
+#define REPLAY_MAX_THREADS  256
+#define REPLAY_CHUNK        4096    // Scores kept on the stack before mapping
+
+static const char *state_names[AQ_N_STATES] = {"GOOD", "MODERATE", "POOR", "HAZARDOUS"};
+
+struct replay_change {
+    uint32_t sample;
+    uint8_t state;
+};
+
+struct replay_shard {
+    uint32_t lo, hi;
+    aq_state_map_t map;             // Whole shard, pass 1
+    int start, end;                 // States before and after the shard, pass 2
+    uint64_t samples[AQ_N_STATES];
+    uint64_t entries[AQ_N_STATES];
+    struct replay_change *changes;
+    size_t n_changes, cap_changes;
+    int err;
+};
+
+struct replay {
+    const struct aq_trace_record *records;
+    aq_state_map_t *maps;           // One per record
+    struct replay_shard shards[REPLAY_MAX_THREADS];
+    int n_shards;
+    pthread_barrier_t pass_done;
+};
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// --- Per-shard counters, shared by the sharded and single runs ---
+static void note_state(struct replay_shard *s, uint32_t sample, int prev, int state) {
+    s->samples[state]++;
+    if (state == prev) return;
+    s->entries[state]++;
+    if (s->n_changes == s->cap_changes) {
+        size_t cap = s->cap_changes ? s->cap_changes * 2 : 1024;
+        struct replay_change *c = realloc(s->changes, cap * sizeof(*c));
+
+        if (!c) {
+            s->err = 1;
+            return;
+        }
+        s->changes = c;
+        s->cap_changes = cap;
+    }
+    s->changes[s->n_changes].sample = sample;
+    s->changes[s->n_changes].state = (uint8_t)state;
+    s->n_changes++;
+}
+
+// --- Pass 1: scores -> state maps ---
+static void map_shard(struct replay *r, struct replay_shard *s) {
+    aq_score_t co[REPLAY_CHUNK], aqi[REPLAY_CHUNK];
+    struct aq_pipeline p;
+    aq_state_map_t m = AQ_STATE_MAP_IDENTITY;
+    uint32_t i, base, len;
+
+    aq_pipeline_init(&p);
+    i = s->lo > AQ_FILTER_WINDOW - 1 ? s->lo - (AQ_FILTER_WINDOW - 1) : 0;
+    for (; i < s->lo; i++) aq_pipeline_score(&p, &r->records[i].reading, &co[0], &aqi[0]);
+
+    for (base = s->lo; base < s->hi; base += len) {
+        len = s->hi - base < REPLAY_CHUNK ? s->hi - base : REPLAY_CHUNK;
+        for (i = 0; i < len; i++) aq_pipeline_score(&p, &r->records[base + i].reading, &co[i], &aqi[i]);
+        aq_state_maps(co, aqi, r->maps + base, (int32_t)len);
+        for (i = 0; i < len; i++) m = aq_state_compose(m, r->maps[base + i]);
+    }
+    s->map = m;
+}
+
+// --- Pass 2: walk the maps from the shard's start state ---
+static void walk_shard(struct replay *r, struct replay_shard *s) {
+    int state = s->start, next;
+    uint32_t i;
+
+    for (i = s->lo; i < s->hi; i++) {
+        next = (r->maps[i] >> (2 * state)) & 3;
+        note_state(s, i, state, next);
+        state = next;
+    }
+    s->end = state;
+}
+
+struct replay_worker {
+    struct replay *r;
+    int id;
+};
+
+static void *replay_worker(void *arg) {
+    struct replay_worker *w = arg;
+    struct replay *r = w->r;
+    struct replay_shard *s = &r->shards[w->id];
+    int k, state = GOOD;
+
+    map_shard(r, s);
+    pthread_barrier_wait(&r->pass_done);
+
+    for (k = 0; k < w->id; k++) state = (r->shards[k].map >> (2 * state)) & 3;
+    s->start = state;
+    walk_shard(r, s);
+    return 0;
+}
+
+static int replay_sharded(struct replay *r, uint32_t n, int n_threads) {
+    pthread_t threads[REPLAY_MAX_THREADS];
+    struct replay_worker workers[REPLAY_MAX_THREADS];
+    int k, err = 0;
+
+    r->maps = malloc(n ? n : 1);
+    if (!r->maps) return -1;
+    if ((uint32_t)n_threads > n) n_threads = n ? (int)n : 1;
+    r->n_shards = n_threads;
+    pthread_barrier_init(&r->pass_done, 0, (unsigned)n_threads);
+    for (k = 0; k < n_threads; k++) {
+        r->shards[k].lo = (uint32_t)((uint64_t)n * k / n_threads);
+        r->shards[k].hi = (uint32_t)((uint64_t)n * (k + 1) / n_threads);
+        workers[k].r = r;
+        workers[k].id = k;
+    }
+    for (k = 1; k < n_threads; k++) {
+        if (pthread_create(&threads[k], 0, replay_worker, &workers[k]) != 0) {
+            // The barrier counts on every shard: no partial runs
+            fprintf(stderr, "aq_replay: cannot start thread %d\n", k);
+            exit(1);
+        }
+    }
+    replay_worker(&workers[0]);
+    for (k = 1; k < n_threads; k++) pthread_join(threads[k], 0);
+    pthread_barrier_destroy(&r->pass_done);
+    free(r->maps);
+    r->maps = 0;
+
+    for (k = 0; k < n_threads; k++) err |= r->shards[k].err;
+    return err ? -1 : 0;
+}
+
+// --- Single pipeline, sample by sample (-s): the reference ---
+static int replay_single(struct replay *r, uint32_t n) {
+    struct replay_shard *s = &r->shards[0];
+    struct aq_pipeline p;
+    int prev;
+    uint32_t i;
+
+    aq_pipeline_init(&p);
+    r->n_shards = 1;
+    s->lo = 0;
+    s->hi = n;
+    s->start = p.state;
+    for (i = 0; i < n; i++) {
+        prev = p.state;
+        note_state(s, i, prev, aq_pipeline_step(&p, &r->records[i].reading));
+    }
+    s->end = p.state;
+    return s->err ? -1 : 0;
+}
+
+static void report(const struct replay *r, uint32_t n, int n_threads, double seconds, FILE *timeline) {
+    uint64_t samples[AQ_N_STATES] = {0}, entries[AQ_N_STATES] = {0};
+    const struct replay_shard *s;
+    size_t changes = 0, c;
+    int k, st;
+
+    for (k = 0; k < r->n_shards; k++) {
+        s = &r->shards[k];
+        for (st = 0; st < AQ_N_STATES; st++) {
+            samples[st] += s->samples[st];
+            entries[st] += s->entries[st];
+        }
+        changes += s->n_changes;
+        if (!timeline) continue;
+        for (c = 0; c < s->n_changes; c++) {
+            fprintf(timeline, "%u,%u,%s\n", (unsigned)r->records[s->changes[c].sample].time_s,
+                    (unsigned)s->changes[c].sample, state_names[s->changes[c].state]);
+        }
+    }
+
+    printf("samples=%u threads=%d seconds=%.3f msamples_per_s=%.1f\n", (unsigned)n, n_threads,
+           seconds, seconds > 0 ? n / seconds * 1e-6 : 0.0);
+    for (st = 0; st < AQ_N_STATES; st++) {
+        printf("state=%s samples=%llu entries=%llu\n", state_names[st],
+               (unsigned long long)samples[st], (unsigned long long)entries[st]);
+    }
+    // alarm_play() starts a pattern on every entry into POOR or HAZARDOUS
+    printf("alarms poor=%llu hazard=%llu transitions=%lu final=%s\n",
+           (unsigned long long)entries[POOR], (unsigned long long)entries[HAZARDOUS],
+           (unsigned long)changes, state_names[r->shards[r->n_shards - 1].end]);
+}
+
+// --- Trace writers (-c, -g) ---
+static int convert_csv(const char *csv, const char *out) {
+    struct aq_trace_writer w;
+    struct aq_reading rd;
+    char line[128];
+    int co, aq, t, h;
+    uint32_t time_s = 0;
+    FILE *f = fopen(csv, "r");
+
+    if (!f) {
+        perror(csv);
+        return 1;
+    }
+    if (aq_trace_create(&w, out) != 0) {
+        fclose(f);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || sscanf(line, "%d,%d,%d,%d", &co, &aq, &t, &h) != 4) continue;
+        rd.co_ppm = (int16_t)(co > 32767 ? 32767 : co);
+        rd.aqi = (int16_t)aq;
+        rd.temp = (int16_t)t;
+        rd.hum = (int16_t)h;
+        // Out-of-range readings never reach the firmware's pipeline; a
+        // pegged CO reading does, clamped
+        if (aq_parse_check(&aq_format_reading, &rd) && aq_trace_add(&w, time_s, &rd) != 0) break;
+        time_s++;
+    }
+    fclose(f);
+    if (aq_trace_finish(&w) != 0) {
+        perror(out);
+        return 1;
+    }
+    return 0;
+}
+
+static uint32_t rng_next(uint32_t *x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+// Slow drift plus an occasional pollution event, so every state shows up
+static int generate(uint32_t n, uint32_t seed, const char *out) {
+    struct aq_trace_writer w;
+    struct aq_reading rd;
+    int co = 20, aq = 60, t = 22, h = 45, event = 0;
+    uint32_t x = seed ? seed : 1, i;
+
+    if (aq_trace_create(&w, out) != 0) return 1;
+    for (i = 0; i < n; i++) {
+        if (event == 0 && rng_next(&x) % 2000 == 0) event = 60 + (int)(rng_next(&x) % 600);
+        if (event > 0) event--;
+        co += (int)(rng_next(&x) % 5) - 2 + (event ? 1 : 0) - (co > 25 && !event);
+        aq += (int)(rng_next(&x) % 7) - 3 + (event ? 2 : 0) - (aq > 70 && !event);
+        co = co < 0 ? 0 : co > 200 ? 200 : co;
+        aq = aq < 0 ? 0 : aq > 300 ? 300 : aq;
+        if (rng_next(&x) % 60 == 0) t += (int)(rng_next(&x) % 3) - 1;
+        if (rng_next(&x) % 30 == 0) h += (int)(rng_next(&x) % 3) - 1;
+        t = t < 10 ? 10 : t > 40 ? 40 : t;
+        h = h < 10 ? 10 : h > 90 ? 90 : h;
+
+        rd.co_ppm = (int16_t)(co > 32767 ? 32767 : co);
+        rd.aqi = (int16_t)aq;
+        rd.temp = (int16_t)t;
+        rd.hum = (int16_t)h;
+        // A glitch now and then, for the median to remove
+        if (rng_next(&x) % 500 == 0) rd.co_ppm = (int16_t)(rng_next(&x) % 200);
+        if (aq_trace_add(&w, i, &rd) != 0) break;
+    }
+    if (aq_trace_finish(&w) != 0) {
+        perror(out);
+        return 1;
+    }
+    return 0;
+}
+
+// --- Flash log dump (-F) ---
+static int dump_log(const char *image, const char *out) {
+    struct aq_log_record rec;
+    uint32_t first, next, seq, t, scan, end_time, records = 0, seeks = 0, errors = 0;
+    FILE *f;
+
+    if (hal_image_open(image) != 0) return 1;
+    if (!(f = fopen(out, "w"))) {
+        perror(out);
+        return 1;
+    }
+
+    aq_log_init();
+    first = aq_log_first();
+    next = aq_log_next();
+    fprintf(f, "seq,time_s,type,state,co,aqi,temp,hum\n");
+    for (seq = first; seq < next; seq++) {
+        if (!aq_log_read(seq, &rec)) continue;      // Page lost to a failed program
+        fprintf(f, "%u,%u,%u,%u,%d,%d,%d,%u\n", (unsigned)rec.seq, (unsigned)rec.time_s, rec.type,
+                rec.state, rec.co_ppm, rec.aqi, rec.temp, rec.hum);
+        records++;
+    }
+    if (fclose(f) != 0) {
+        perror(out);
+        return 1;
+    }
+
+    // Time only goes up, so one scan pointer serves every second
+    if (records > 0) {
+        scan = first;
+        while (!aq_log_read(scan, &rec)) scan++;
+        t = rec.time_s;
+        aq_log_read(next - 1, &rec);
+        end_time = rec.time_s + 1;
+        for (; t <= end_time; t++) {
+            while (scan < next && (!aq_log_read(scan, &rec) || rec.time_s < t)) scan++;
+            seeks++;
+            if (aq_log_seek(t) != scan) {
+                if (errors++ < 10) {
+                    fprintf(stderr, "seek %u: got record %u, scan found %u\n", (unsigned)t,
+                            (unsigned)aq_log_seek(t), (unsigned)scan);
+                }
+            }
+        }
+    }
+    printf("records=%u first=%u next=%u time_s=%u seeks=%u seek_errors=%u\n", (unsigned)records,
+           (unsigned)first, (unsigned)next, (unsigned)aq_log_time(), (unsigned)seeks, (unsigned)errors);
+    return errors ? 1 : 0;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: aq_replay [-j threads] [-o timeline.csv] [-s] trace.bin\n"
+                    "       aq_replay -c trace.csv trace.bin\n"
+                    "       aq_replay -g samples [-S seed] trace.bin\n"
+                    "       aq_replay -F flash.bin log.csv\n");
+}
+
+int main(int argc, char **argv) {
+    static struct replay r;
+    struct aq_trace t;
+    const char *csv = 0, *flash_path = 0, *timeline_path = 0;
+    FILE *timeline = 0;
+    long n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t gen = 0, seed = 1;
+    int opt, single = 0, err;
+    double start, seconds;
+
+    while ((opt = getopt(argc, argv, "j:o:sc:g:S:F:")) != -1) {
+        switch (opt) {
+        case 'j': n_threads = atol(optarg); break;
+        case 'o': timeline_path = optarg; break;
+        case 's': single = 1; break;
+        case 'c': csv = optarg; break;
+        case 'g': gen = (uint32_t)strtoul(optarg, 0, 0); break;
+        case 'S': seed = (uint32_t)strtoul(optarg, 0, 0); break;
+        case 'F': flash_path = optarg; break;
+        default: usage(); return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage();
+        return 1;
+    }
+    if (csv) return convert_csv(csv, argv[optind]);
+    if (gen) return generate(gen, seed, argv[optind]);
+    if (flash_path) return dump_log(flash_path, argv[optind]);
+    if (n_threads < 1) n_threads = 1;
+    if (n_threads > REPLAY_MAX_THREADS) n_threads = REPLAY_MAX_THREADS;
+
+    if (aq_trace_open(&t, argv[optind]) != 0) return 1;
+    if (timeline_path && !(timeline = fopen(timeline_path, "w"))) {
+        perror(timeline_path);
+        return 1;
+    }
+
+    // Back-end tables are built once, before any thread reads them
+    aq_model_init();
+    r.records = t.records;
+    start = now_s();
+    err = single ? replay_single(&r, t.count) : replay_sharded(&r, t.count, (int)n_threads);
+    seconds = now_s() - start;
+    if (err) {
+        fprintf(stderr, "aq_replay: out of memory\n");
+        return 1;
+    }
+
+    if (timeline) fprintf(timeline, "time_s,sample,state\n");
+    report(&r, t.count, single ? 1 : r.n_shards, seconds, timeline);
+    if (timeline && fclose(timeline) != 0) {
+        perror(timeline_path);
+        return 1;
+    }
+    aq_trace_close(&t);
+    return 0;
+}
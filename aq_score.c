@@ -0,0 +1,108 @@
+/*
+ * ==========================================================================
+ * aq_score.c - Linear hazard scorers (CO and AQI)
+ * ==========================================================================
+ * Split out of code.c so the host tools (benchmarks, replay) link the
+ * exact functions the firmware runs.
+ * ==========================================================================
+ */
+
+#include "aq_score.h"
+
+// *** IMPROVED ML MODEL PARAMETERS ***
+// More balanced weights that consider environmental factors properly
+
+// Weights are aq_score_t: float, or fixed point when built with AQ_FIXED_POINT
+
+// CO Model: Focuses more on CO but considers temperature/humidity effects
+const aq_score_t CO_PPM_WEIGHT = AQ_SCORE(0.5f);      // Reduced from 0.8
+const aq_score_t CO_TEMP_WEIGHT = AQ_SCORE(0.05f);    // Reduced impact
+const aq_score_t CO_HUM_WEIGHT = AQ_SCORE(0.02f);     // Reduced impact
+const aq_score_t CO_BIAS = AQ_SCORE(-5.0f);           // Less negative
+
+// AQI Model: Balanced weights
+const aq_score_t AQI_VAL_WEIGHT = AQ_SCORE(0.4f);     // Reduced from 0.7
+const aq_score_t AQI_TEMP_WEIGHT = AQ_SCORE(0.03f);   // Positive now (heat increases pollution)
+const aq_score_t AQI_HUM_WEIGHT = AQ_SCORE(0.02f);    // Reduced from 0.25
+const aq_score_t AQI_BIAS = AQ_SCORE(-3.0f);          // Slightly negative
+
+// *** IMPROVED ML PREDICTION FUNCTIONS ***
+
+/*
+ * =======================================================
+ * PREDICTION FUNCTION: predict_co_hazard
+ * =======================================================
+ * Features: CO PPM, Temperature, Humidity
+ * Output: Hazard Score (0-100 scale)
+ * 
+ * Improvements:
+ * - Reduced weight on CO for less sensitivity
+ * - Minor environmental factor adjustments
+ * - Better baseline offset
+ * =======================================================
+ */
+aq_score_t predict_co_hazard(int ppm, int temp_c, int hum_pct) {
+    aq_score_t score;
+
+    ppm = AQ_INPUT(ppm);
+    temp_c = AQ_INPUT(temp_c);
+    hum_pct = AQ_INPUT(hum_pct);
+    
+    // Base score from CO level
+    score = ppm * CO_PPM_WEIGHT;
+    
+    // Temperature adjustment (higher temp = slightly worse)
+    score += (temp_c - 20) * CO_TEMP_WEIGHT;
+    
+    // Humidity adjustment (extreme humidity = slightly worse)
+    int hum_deviation = (hum_pct > 60) ? (hum_pct - 60) : 0;
+    score += hum_deviation * CO_HUM_WEIGHT;
+    
+    // Add bias
+    score += CO_BIAS;
+    
+    // Clamp to valid range
+    if (score < AQ_SCORE(0)) score = AQ_SCORE(0);
+    if (score > AQ_SCORE(100)) score = AQ_SCORE(100);
+    
+    return score;
+}
+
+/*
+ * =======================================================
+ * PREDICTION FUNCTION: predict_aqi_hazard
+ * =======================================================
+ * Features: AQI, Temperature, Humidity
+ * Output: Hazard Score (0-150 scale)
+ * 
+ * Improvements:
+ * - More reasonable AQI weight
+ * - Temperature increases pollution perception
+ * - Humidity has minimal effect
+ * =======================================================
+ */
+aq_score_t predict_aqi_hazard(int aqi_val, int temp_c, int hum_pct) {
+    aq_score_t score;
+
+    aqi_val = AQ_INPUT(aqi_val);
+    temp_c = AQ_INPUT(temp_c);
+    hum_pct = AQ_INPUT(hum_pct);
+    
+    // Base score from AQI
+    score = aqi_val * AQI_VAL_WEIGHT;
+    
+    // Temperature adjustment (heat makes pollution worse)
+    score += (temp_c - 20) * AQI_TEMP_WEIGHT;
+    
+    // Humidity adjustment (minimal effect)
+    score += (hum_pct - 50) * AQI_HUM_WEIGHT;
+    
+    // Add bias
+    score += AQI_BIAS;
+    
+    // Clamp to valid range
+    if (score < AQ_SCORE(0)) score = AQ_SCORE(0);
+    if (score > AQ_SCORE(150)) score = AQ_SCORE(150);
+    
+    return score;
+}
@@ -0,0 +1,18 @@
+/*
+ * ==========================================================================
+ * aq_score.h - Linear hazard scorers (CO and AQI)
+ * ==========================================================================
+ */
+
+#ifndef AQ_SCORE_H
+#define AQ_SCORE_H
+
+#include "aq_fixed.h"
+
+// CO hazard score, 0-100
+aq_score_t predict_co_hazard(int ppm, int temp_c, int hum_pct);
+
+// AQI hazard score, 0-150
+aq_score_t predict_aqi_hazard(int aqi_val, int temp_c, int hum_pct);
+
+#endif // AQ_SCORE_H
@@ -0,0 +1,48 @@
+/*
+ * ==========================================================================
+ * aq_state.c - Evaluate the state table over a recorded trace (host side)
+ * ==========================================================================
+ * The state of sample i depends on sample i-1, which keeps a plain loop
+ * serial. Pass 1 removes that dependency: it evaluates every sample from
+ * all four previous states at once, a fixed-shape loop the compiler can
+ * vectorise. Pass 2 walks the packed maps, one shift and mask per sample.
+ *
+ * The split only pays once pass 1 is vectorised: build with -O3 (or
+ * -O2 -ftree-vectorize). At plain -O2, GCC leaves it scalar and
+ * aq_state_trace() is slower than the serial loop.
+ * ==========================================================================
+ */
+
+#include "aq_state.h"
+
+#define AQ_STATE_CHUNK  256     // Maps kept on the stack between the passes
+
+void aq_state_maps(const aq_score_t *co, const aq_score_t *aqi, aq_state_map_t *maps, int32_t n) {
+    int32_t i;
+    int p;
+
+    for (i = 0; i < n; i++) {
+        aq_state_map_t m = 0;
+
+        for (p = 0; p < AQ_N_STATES; p++) {
+            m |= (aq_state_map_t)(aq_state_next(p, co[i], aqi[i]) << (2 * p));
+        }
+        maps[i] = m;
+    }
+}
+
+int aq_state_trace(const aq_score_t *co, const aq_score_t *aqi, uint8_t *states,
+                   int32_t n, int state) {
+    aq_state_map_t maps[AQ_STATE_CHUNK];
+    int32_t base, i, len;
+
+    for (base = 0; base < n; base += len) {
+        len = n - base < AQ_STATE_CHUNK ? n - base : AQ_STATE_CHUNK;
+        aq_state_maps(co + base, aqi + base, maps, len);
+        for (i = 0; i < len; i++) {
+            state = (maps[i] >> (2 * state)) & 3;
+            states[base + i] = (uint8_t)state;
+        }
+    }
+    return state;
+}
@@ -0,0 +1,123 @@
+/*
+ * ==========================================================================
+ * aq_state.h - Air quality state from the hazard scores, table driven
+ * ==========================================================================
+ * aq_state_thr[prev][input][level - 1] is the score an input needs for
+ * the system to be at `level` or above, coming from state `prev`. The
+ * next state is the highest level any input reaches:
+ *
+ *     next = max over inputs of count(score >= thr[prev][input][k])
+ *
+ * Six compares per sample whatever the state, and no branch on the data.
+ *
+ * Each level has an ON threshold (reached from a lower state) and an OFF
+ * threshold (used while already in that state, for hysteresis). The table
+ * is built from them by the preprocessor. Only POOR has a dead band today;
+ * MODERATE and HAZARDOUS use OFF == ON.
+ *
+ * Counting equals the if/else cascade only while every row of the table
+ * rises with the level; the #if checks below enforce that.
+ *
+ * aq_state_trace() (aq_state.c, host side) runs the same evaluator over a
+ * recorded trace and gives the same states as calling aq_state_next()
+ * sample by sample.
+ * ==========================================================================
+ */
+
+#ifndef AQ_STATE_H
+#define AQ_STATE_H
+
+#include <stdint.h>
+#include "aq_fixed.h"
+
+// --- Air Quality States ---
+enum AirQualityState { GOOD, MODERATE, POOR, HAZARDOUS };
+#define AQ_N_STATES     4
+
+// *** IMPROVED THRESHOLDS - Less Strict *** (whole score points)
+// CO Score Thresholds
+#define CO_SCORE_MODERATE_ON   30   // Was 20
+#define CO_SCORE_POOR_ON       50   // Was 30 - Buzzer ON
+#define CO_SCORE_HAZARD_ON     75   // Was 40
+
+// AQI Score Thresholds
+#define AQI_SCORE_MODERATE_ON  50   // Was 70
+#define AQI_SCORE_POOR_ON      90   // Was 110 - Buzzer ON
+#define AQI_SCORE_HAZARD_ON    150  // Was 180
+
+// Hysteresis - wider gap for stability
+#define CO_SCORE_MODERATE_OFF  CO_SCORE_MODERATE_ON
+#define CO_SCORE_POOR_OFF      45   // Was 27
+#define CO_SCORE_HAZARD_OFF    CO_SCORE_HAZARD_ON
+#define AQI_SCORE_MODERATE_OFF AQI_SCORE_MODERATE_ON
+#define AQI_SCORE_POOR_OFF     80   // Was 100
+#define AQI_SCORE_HAZARD_OFF   AQI_SCORE_HAZARD_ON
+
+#if CO_SCORE_MODERATE_ON > CO_SCORE_POOR_ON || CO_SCORE_POOR_ON > CO_SCORE_HAZARD_ON || \
+    CO_SCORE_MODERATE_OFF > CO_SCORE_POOR_ON || \
+    CO_SCORE_POOR_OFF < CO_SCORE_MODERATE_ON || CO_SCORE_POOR_OFF > CO_SCORE_HAZARD_ON || \
+    CO_SCORE_HAZARD_OFF < CO_SCORE_POOR_ON
+#error "CO state thresholds must rise with the level"
+#endif
+#if AQI_SCORE_MODERATE_ON > AQI_SCORE_POOR_ON || AQI_SCORE_POOR_ON > AQI_SCORE_HAZARD_ON || \
+    AQI_SCORE_MODERATE_OFF > AQI_SCORE_POOR_ON || \
+    AQI_SCORE_POOR_OFF < AQI_SCORE_MODERATE_ON || AQI_SCORE_POOR_OFF > AQI_SCORE_HAZARD_ON || \
+    AQI_SCORE_HAZARD_OFF < AQI_SCORE_POOR_ON
+#error "AQI state thresholds must rise with the level"
+#endif
+
+// OFF threshold while in that state, ON threshold otherwise
+#define AQ_STATE_THR(prev, level, on, off)  AQ_SCORE((prev) == (level) ? (off) : (on))
+
+#define AQ_STATE_ROW(prev) {                                                    \
+    { AQ_STATE_THR(prev, MODERATE, CO_SCORE_MODERATE_ON, CO_SCORE_MODERATE_OFF), \
+      AQ_STATE_THR(prev, POOR, CO_SCORE_POOR_ON, CO_SCORE_POOR_OFF),             \
+      AQ_STATE_THR(prev, HAZARDOUS, CO_SCORE_HAZARD_ON, CO_SCORE_HAZARD_OFF) },  \
+    { AQ_STATE_THR(prev, MODERATE, AQI_SCORE_MODERATE_ON, AQI_SCORE_MODERATE_OFF), \
+      AQ_STATE_THR(prev, POOR, AQI_SCORE_POOR_ON, AQI_SCORE_POOR_OFF),           \
+      AQ_STATE_THR(prev, HAZARDOUS, AQI_SCORE_HAZARD_ON, AQI_SCORE_HAZARD_OFF) } }
+
+// [previous state][0 = CO, 1 = AQI][level - 1]
+static const aq_score_t aq_state_thr[AQ_N_STATES][2][AQ_N_STATES - 1] = {
+    AQ_STATE_ROW(GOOD),
+    AQ_STATE_ROW(MODERATE),
+    AQ_STATE_ROW(POOR),
+    AQ_STATE_ROW(HAZARDOUS)
+};
+
+static inline int aq_state_next(int prev, aq_score_t co_score, aq_score_t aqi_score) {
+    const aq_score_t *co = aq_state_thr[prev][0];
+    const aq_score_t *aq = aq_state_thr[prev][1];
+    int n_co = (co_score >= co[0]) + (co_score >= co[1]) + (co_score >= co[2]);
+    int n_aq = (aqi_score >= aq[0]) + (aqi_score >= aq[1]) + (aqi_score >= aq[2]);
+
+    return n_co > n_aq ? n_co : n_aq;
+}
+
+// --- Offline evaluation (aq_state.c) ---
+// Next state from every previous state, 2 bits each: (map >> 2*prev) & 3
+typedef uint8_t aq_state_map_t;
+
+#define AQ_STATE_MAP_IDENTITY   0xE4    // Every state maps to itself
+
+// Map of `a` followed by `b`: lets a trace be split, mapped in pieces,
+// and the start state of each piece found from the one before
+static inline aq_state_map_t aq_state_compose(aq_state_map_t a, aq_state_map_t b) {
+    aq_state_map_t m = 0;
+    int p;
+
+    for (p = 0; p < AQ_N_STATES; p++) {
+        m |= (aq_state_map_t)(((b >> (2 * ((a >> (2 * p)) & 3))) & 3) << (2 * p));
+    }
+    return m;
+}
+
+// Pass 1, no dependency between samples: one map per sample
+void aq_state_maps(const aq_score_t *co, const aq_score_t *aqi, aq_state_map_t *maps, int32_t n);
+
+// Both passes: states[i] is the state after sample i, starting from
+// `state`. Returns the final state.
+int aq_state_trace(const aq_score_t *co, const aq_score_t *aqi, uint8_t *states,
+                   int32_t n, int state);
+
+#endif // AQ_STATE_H
@@ -0,0 +1,103 @@
+/*
+ * ==========================================================================
+ * aq_trace.c - Binary reading traces for host-side replay (POSIX)
+ * ==========================================================================
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "aq_trace.h"
+
+int aq_trace_open(struct aq_trace *t, const char *path) {
+    const struct aq_trace_header *h;
+    struct stat st;
+    int fd;
+
+    memset(t, 0, sizeof(*t));
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(*h)) {
+        fprintf(stderr, "%s: not a trace\n", path);
+        close(fd);
+        return -1;
+    }
+    t->map_len = (size_t)st.st_size;
+    t->map = mmap(0, t->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (t->map == MAP_FAILED) {
+        perror(path);
+        t->map = 0;
+        return -1;
+    }
+
+    h = (const struct aq_trace_header *)t->map;
+    if (h->magic != AQ_TRACE_MAGIC || h->version != AQ_TRACE_VERSION ||
+        h->record_size != sizeof(struct aq_trace_record)) {
+        fprintf(stderr, "%s: not a version %d trace\n", path, AQ_TRACE_VERSION);
+        aq_trace_close(t);
+        return -1;
+    }
+    if ((t->map_len - sizeof(*h)) / sizeof(struct aq_trace_record) < h->count) {
+        fprintf(stderr, "%s: truncated (%u records in the header)\n", path, (unsigned)h->count);
+        aq_trace_close(t);
+        return -1;
+    }
+    t->records = (const struct aq_trace_record *)(h + 1);
+    t->count = h->count;
+
+    // Replay reads the file front to back, once
+    madvise(t->map, t->map_len, MADV_SEQUENTIAL);
+    return 0;
+}
+
+void aq_trace_close(struct aq_trace *t) {
+    if (t->map) munmap(t->map, t->map_len);
+    memset(t, 0, sizeof(*t));
+}
+
+static int write_header(FILE *f, uint32_t count) {
+    struct aq_trace_header h;
+
+    memset(&h, 0, sizeof(h));
+    h.magic = AQ_TRACE_MAGIC;
+    h.version = AQ_TRACE_VERSION;
+    h.record_size = sizeof(struct aq_trace_record);
+    h.count = count;
+    return fwrite(&h, sizeof(h), 1, f) == 1 ? 0 : -1;
+}
+
+int aq_trace_create(struct aq_trace_writer *w, const char *path) {
+    w->count = 0;
+    w->f = fopen(path, "wb");
+    if (!w->f) {
+        perror(path);
+        return -1;
+    }
+    return write_header(w->f, 0);
+}
+
+int aq_trace_add(struct aq_trace_writer *w, uint32_t time_s, const struct aq_reading *r) {
+    struct aq_trace_record rec;
+
+    if (w->count == UINT32_MAX) return -1;
+    rec.time_s = time_s;
+    rec.reading = *r;
+    if (fwrite(&rec, sizeof(rec), 1, w->f) != 1) return -1;
+    w->count++;
+    return 0;
+}
+
+int aq_trace_finish(struct aq_trace_writer *w) {
+    int err = fseek(w->f, 0, SEEK_SET) != 0 || write_header(w->f, w->count) != 0;
+
+    err |= fclose(w->f) != 0;
+    w->f = 0;
+    return err ? -1 : 0;
+}
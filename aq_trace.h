@@ -0,0 +1,67 @@
+/*
+ * ==========================================================================
+ * aq_trace.h - Binary reading traces for host-side replay
+ * ==========================================================================
+ * A 16-byte header, then fixed-size records in time order:
+ *
+ *   header   magic "AQTR", version, record size, record count, reserved
+ *   record   uint32 time_s, struct aq_reading            (12 bytes)
+ *
+ * Host byte order (little-endian on every machine we use). Fixed-size
+ * records let a reader map the file and index it directly, and let a
+ * trace be split anywhere. aq_trace_open() maps the file read-only; the
+ * records are never copied.
+ * ==========================================================================
+ */
+
+#ifndef AQ_TRACE_H
+#define AQ_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "aq_parse.h"
+
+#define AQ_TRACE_MAGIC      0x52545141u     // "AQTR" in the file
+#define AQ_TRACE_VERSION    1
+
+struct aq_trace_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct aq_trace_record {
+    uint32_t time_s;
+    struct aq_reading reading;
+};
+
+typedef char aq_trace_header_is_16_bytes[sizeof(struct aq_trace_header) == 16 ? 1 : -1];
+typedef char aq_trace_record_is_12_bytes[sizeof(struct aq_trace_record) == 12 ? 1 : -1];
+
+// --- Reader ---
+struct aq_trace {
+    const struct aq_trace_record *records;
+    uint32_t count;
+    void *map;
+    size_t map_len;
+};
+
+// 0 on success; on failure prints why to stderr
+int aq_trace_open(struct aq_trace *t, const char *path);
+void aq_trace_close(struct aq_trace *t);
+
+// --- Writer ---
+struct aq_trace_writer {
+    FILE *f;
+    uint32_t count;
+};
+
+int aq_trace_create(struct aq_trace_writer *w, const char *path);
+int aq_trace_add(struct aq_trace_writer *w, uint32_t time_s, const struct aq_reading *r);
+// Writes the final count into the header and closes the file
+int aq_trace_finish(struct aq_trace_writer *w);
+
+#endif // AQ_TRACE_H
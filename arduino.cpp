@@ -1,5 +1,11 @@
 #include <DHT.h>
 
+// -------------------- Link Protocol --------------------
+// 1 = binary frames (aq_link.h), 0 = text lines "co,aqi,t,h,seq,age_ms".
+// Must match AQ_LINK_PROTOCOL in the LPC1768 build.
+#define AQ_LINK_PROTOCOL 0
+#include "aq_link.h"
+
 // -------------------- Pin Config --------------------
 #define MQ7_PIN     A0
 #define MQ135_PIN   A1
@@ -23,6 +29,14 @@ float CO2_curve[3] = {2.3, 0.72, -0.34};
 float NH3_curve[3] = {1.5, 0.50, -0.44};
 float NOx_curve[3] = {1.0, 0.60, -0.41};
 
+uint8_t link_seq = 0;               // +1 per reading line or frame sent
+#if AQ_LINK_PROTOCOL
+struct aq_link_decoder link_rx;
+uint32_t link_baud = AQ_LINK_BASE_BAUD;
+unsigned long link_last_heard;
+unsigned long link_next_try = 0;
+#endif
+
 // -------------------- Functions --------------------
 int readSmooth(int pin) {
   long sum = 0;
@@ -57,15 +71,77 @@ int mq135_get_AQI(float co2, float nh3, float nox) {
   return aqi;
 }
 
+#if AQ_LINK_PROTOCOL
+// Read whatever the LPC sent; returns the type of the last good frame (0 if none)
+uint8_t link_poll() {
+  uint8_t type = 0;
+  while (Serial.available()) {
+    if (aq_link_decode_byte(&link_rx, Serial.read()) == AQ_LINK_FRAME) {
+      link_last_heard = millis();
+      type = link_rx.type;
+    }
+  }
+  return type;
+}
+
+// Ask for AQ_LINK_FAST_BAUD; fall back to the base rate if the LPC goes quiet
+void link_negotiate() {
+  uint8_t frame[AQ_LINK_MAX_FRAME];
+  unsigned long start;
+  int n;
+
+  if (link_poll() == AQ_LINK_BAUD_ACK) return;  // Stale ACK, ignore
+
+  if (link_baud != AQ_LINK_BASE_BAUD) {
+    if (millis() - link_last_heard > AQ_LINK_TIMEOUT_MS) {
+      Serial.flush();
+      Serial.begin(AQ_LINK_BASE_BAUD);
+      link_baud = AQ_LINK_BASE_BAUD;
+      link_next_try = millis() + AQ_LINK_RETRY_MS;
+    }
+    return;
+  }
+  if ((long)(millis() - link_next_try) < 0) return;
+
+  n = aq_link_encode_baud(frame, AQ_LINK_BAUD_REQ, link_seq++, AQ_LINK_FAST_BAUD);
+  Serial.write(frame, n);
+  start = millis();
+  while (millis() - start < 500) {  // LPC answers from its 100 ms main loop
+    if (link_poll() == AQ_LINK_BAUD_ACK && aq_link_get_baud(&link_rx) == AQ_LINK_FAST_BAUD) {
+      Serial.flush();
+      Serial.begin(AQ_LINK_FAST_BAUD);
+      link_baud = AQ_LINK_FAST_BAUD;
+      link_last_heard = millis();
+      return;
+    }
+  }
+  link_next_try = millis() + AQ_LINK_RETRY_MS;  // No TX wire, or refused
+}
+
+// age_ms: from the start of the capture to now (aq_lat.h on the LPC)
+void link_send_reading(int co, int aqi, int t, int h, unsigned long age_ms) {
+  uint8_t frame[AQ_LINK_MAX_FRAME];
+  int n;
+
+  if (age_ms > 65535) age_ms = 65535;
+  n = aq_link_encode_reading(frame, link_seq++, co, aqi, t, h, age_ms);
+  Serial.write(frame, n);
+}
+#endif
+
 // -------------------- Setup --------------------
 void setup() {
   Serial.begin(9600);
+#if AQ_LINK_PROTOCOL
+  aq_link_decoder_init(&link_rx);
+#endif
   dht.begin();
   mq135_cal_start = millis();
 }
 
 // -------------------- Loop --------------------
 void loop() {
+  unsigned long capture_ms = millis();  // The reading's timestamp
   int mq7_raw = readSmooth(MQ7_PIN);
   int mq135_raw = readSmooth(MQ135_PIN);
 
@@ -89,11 +165,25 @@ void loop() {
   float t = dht.readTemperature();
 
   if (!isnan(h) && !isnan(t)) {
-    Serial.print((int)co_ppm); Serial.print(",");
+#if AQ_LINK_PROTOCOL
+    link_send_reading((int)min(co_ppm, 32767.0f), aqi, (int)t, (int)h, millis() - capture_ms);
+#else
+    // age_ms: from the start of the capture to now (aq_lat.h on the LPC)
+    unsigned long age_ms = min(millis() - capture_ms, 32767UL);
+
+    // rs = 0 (ADC pegged) gives infinite ppm: send the int16 maximum
+    Serial.print((int)min(co_ppm, 32767.0f)); Serial.print(",");
     Serial.print(aqi);         Serial.print(",");
     Serial.print((int)t);      Serial.print(",");
-    Serial.println((int)h);
+    Serial.print((int)h);      Serial.print(",");
+    Serial.print(link_seq++);  Serial.print(",");
+    Serial.println(age_ms);
+#endif
   }
 
+#if AQ_LINK_PROTOCOL
+  link_negotiate();
+#endif
+
   delay(1000);
 }
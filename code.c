@@ -7,69 +7,67 @@
  * ==========================================================================
  */
 
-#include <LPC17xx.h>
-#include <stdio.h>
 #include <string.h>
+#include "hal.h"
+#include "fmt.h"
+#include "lcd.h"
+#include "lcd_fb.h"
+#include "rx_queue.h"
+#include "aq_link.h"
 #include "aq_model.h"
-
-// --- Pin Definitions (ALS Board) ---
-#define BUZZER          (1 << 11)
-#define LCD_DATA_MASK   (0xF << 23)
-#define LCD_RS          (1 << 27)
-#define LCD_EN          (1 << 28)
-
-// --- Air Quality States ---
-enum AirQualityState { GOOD, MODERATE, POOR, HAZARDOUS };
+#include "sched.h"
+#include "alarm.h"
+#include "aq_state.h"
+#include "aq_pipeline.h"
+#include "aq_log.h"
+#include "aq_prof.h"
+#include "aq_lat.h"
+
+// --- Air Quality States (thresholds in aq_state.h) ---
 enum AirQualityState currentState = GOOD;
 const char *stateNames[] = {"GOOD", "MODERATE", "POOR", "HAZARD"};
 
-// *** IMPROVED ML MODEL PARAMETERS ***
-// More balanced weights that consider environmental factors properly
-
-// CO Model: Focuses more on CO but considers temperature/humidity effects
-const float CO_PPM_WEIGHT = 0.5f;      // Reduced from 0.8
-const float CO_TEMP_WEIGHT = 0.05f;    // Reduced impact
-const float CO_HUM_WEIGHT = 0.02f;     // Reduced impact
-const float CO_BIAS = -5.0f;           // Less negative
-
-// AQI Model: Balanced weights
-const float AQI_VAL_WEIGHT = 0.4f;     // Reduced from 0.7
-const float AQI_TEMP_WEIGHT = 0.03f;   // Positive now (heat increases pollution)
-const float AQI_HUM_WEIGHT = 0.02f;    // Reduced from 0.25
-const float AQI_BIAS = -3.0f;          // Slightly negative
-
-// *** IMPROVED THRESHOLDS - Less Strict ***
-// CO Score Thresholds
-#define CO_SCORE_MODERATE_ON   30.0f   // Was 20
-#define CO_SCORE_POOR_ON       50.0f   // Was 30 - Buzzer ON
-#define CO_SCORE_HAZARD_ON     75.0f   // Was 40
-
-// AQI Score Thresholds  
-#define AQI_SCORE_MODERATE_ON  50.0f   // Was 70
-#define AQI_SCORE_POOR_ON      90.0f   // Was 110 - Buzzer ON
-#define AQI_SCORE_HAZARD_ON    150.0f  // Was 180
-
-// Hysteresis - wider gap for stability
-#define CO_SCORE_POOR_OFF      45.0f   // Was 27
-#define AQI_SCORE_POOR_OFF     80.0f   // Was 100
-
 // Display max values
 #define CO_MAX_PPM 200  // Changed from 100
 #define AQI_MAX 300     // Changed from 500
 
 // --- Globals ---
-volatile int data_ready = 0;
-char rx_buffer[40];
-char lcdBuffer[20];
+#if AQ_LINK_PROTOCOL
+struct aq_link_decoder rx_link; // Decodes UART1 frames in the ISR
+#else
+struct aq_parser rx_parser;    // Parses UART1 bytes in the ISR
+uint8_t rx_seq, rx_have_seq;    // Last line's seq field
+uint32_t rx_lines_lost;         // Gaps in the seq fields
+#endif
+struct rx_queue rx_frames;     // Parsed lines, filled by the ISR
+char lcdBuffer[24];             // One LCD line (fields may overflow 16; lcd_fb clips)
 int co_ppm = 0, aqi = 0, temp = 0, hum = 0;
-int display_cycle = 0;
+struct aq_pipeline pipeline;   // Filters, scores and state (aq_pipeline.h)
 
-// Buzzer pattern control
-int buzzer_enabled = 0;
-int buzzer_counter = 0;
-#define BUZZER_ON_TIME 10    // 100ms on (10 * 10ms loop delay)
-#define BUZZER_OFF_TIME 10   // 100ms off (10 * 10ms loop delay)
-#define BUZZER_PATTERN_TOTAL (BUZZER_ON_TIME + BUZZER_OFF_TIME)
+// Flash log: one reading record per window (its peaks), plus every state change
+#define LOG_EVERY       AQ_FILTER_WINDOW
+int display_cycle = 0;
+int sensor_error = 0;
+int splash_done = 0;
+
+// Scheduler tasks
+int readings_task, display_task, splash_task, log_task;
+#if AQ_LINK_PROTOCOL
+int link_task;
+#endif
+#if AQ_PROF || AQ_LAT
+int debug_task;
+#endif
+
+#if AQ_LAT
+// 8-N-1: ten bits per byte
+#define RX_BYTE_US(baud)    (10000000u / (baud))
+uint32_t rx_sent_us;            // Arduino's write of the frame being received
+uint32_t lat_state_us;          // Last reading's state decided, for the display hop
+int lat_display_pending;
+uint32_t lat_skip;              // Frames that waited out the splash, not measured
+uint32_t lat_lost_base;         // rx_lost() at the last 'r'
+#endif
 
 // Custom LCD characters for bar graph
 unsigned char bar_chars[5][8] = {
@@ -80,373 +78,483 @@ unsigned char bar_chars[5][8] = {
     {0x00,0x00,0x1F,0x1F,0x1F,0x1F,0x1F,0x1F}
 };
 
-// --- Timer Setup ---
-void initTimer0(void) {
-    uint32_t pclk; 
-    LPC_SC->PCONP |= (1 << 1);
-    pclk = SystemCoreClock / 4;
-    LPC_TIM0->CTCR = 0x0;
-    LPC_TIM0->PR = (pclk / 1000000) - 1;  
-    LPC_TIM0->TCR = 0x02;
-}
-
-void delayUS(unsigned int us) {
-    LPC_TIM0->TCR = 0x02;
-    LPC_TIM0->TC = 0;
-    LPC_TIM0->TCR = 0x01;
-    while (LPC_TIM0->TC < us);
-    LPC_TIM0->TCR = 0x00;
-}
-
-void delayMS(unsigned int ms) {
-    while (ms--) delayUS(1000);
-}
-
-// --- LCD Functions ---
-void lcd_pulse_enable(void) {
-    LPC_GPIO0->FIOSET = LCD_EN;
-    delayUS(1);
-    LPC_GPIO0->FIOCLR = LCD_EN;
-    delayUS(1);
-}
-
-void lcd_send_nibble(unsigned char nibble) {
-    LPC_GPIO0->FIOCLR = LCD_DATA_MASK;
-    LPC_GPIO0->FIOSET = ((nibble & 0x0F) << 23);
-    lcd_pulse_enable();
-}
-
-void lcd_send_byte(unsigned char byte, int is_data) {
-    if (is_data) LPC_GPIO0->FIOSET = LCD_RS;
-    else LPC_GPIO0->FIOCLR = LCD_RS;
-    lcd_send_nibble(byte >> 4);
-    lcd_send_nibble(byte & 0x0F);
-}
-
-void lcd_command(unsigned char cmd) {
-    lcd_send_byte(cmd, 0);
-    delayUS(50);
-}
-
-void lcd_data(unsigned char data) {
-    lcd_send_byte(data, 1);
-    delayUS(50);
-}
-
-void lcd_create_char(unsigned char location, unsigned char *pattern) {
-    int i; 
-    lcd_command(0x40 | (location << 3));
-    for (i = 0; i < 8; i++) lcd_data(pattern[i]);
-    lcd_command(0x80);
-}
-
-void lcd_init(void) {
-    int i; 
-    LPC_GPIO0->FIODIR |= LCD_DATA_MASK | LCD_RS | LCD_EN;
-    delayMS(20);
-    lcd_send_nibble(0x03); delayMS(5);
-    lcd_send_nibble(0x03); delayUS(100);
-    lcd_send_nibble(0x03); delayUS(100);
-    lcd_send_nibble(0x02); delayUS(100);
-    lcd_command(0x28);
-    lcd_command(0x0C);
-    lcd_command(0x06);
-    lcd_command(0x01);
-    delayMS(2);
-    for (i = 0; i < 5; i++) lcd_create_char(i, bar_chars[i]);
-}
-
-void lcd_string(const char *str) {
-    while (*str) {
-        lcd_data(*str++);
-    }
-}
-
-// --- UART1 Setup ---
-void init_uart1(void) {
-    uint32_t pclk;
-    uint16_t divisor;
-    
-    LPC_SC->PCONP |= (1 << 4);
-    LPC_PINCON->PINSEL0 |= (1 << 30);
-    LPC_PINCON->PINSEL1 |= (1 << 0);
-    pclk = SystemCoreClock / 4;
-    divisor = pclk / (16 * 9600);
-    LPC_UART1->LCR = 0x83;
-    LPC_UART1->DLL = divisor & 0xFF;
-    LPC_UART1->DLM = (divisor >> 8) & 0xFF;
-    LPC_UART1->LCR = 0x03;
-    LPC_UART1->FCR = 0x07;
-    LPC_UART1->IER = (1 << 0);
-    NVIC_EnableIRQ(UART1_IRQn);
-}
+// --- UART1 Receive ---
+#if AQ_LINK_PROTOCOL
+volatile uint32_t link_baud_request;    // Set by the ISR on BAUD_REQ
+uint32_t link_baud = AQ_LINK_BASE_BAUD;
 
 void UART1_IRQHandler(void) {
-    static int rx_index = 0;
-    char c;
+    struct rx_frame *frame;
+    uint8_t c;
     
-    while (LPC_UART1->LSR & 0x01) {
-        c = LPC_UART1->RBR;
-        if (c == '\n' || c == '\r') {
-            if (rx_index > 0) {
-                rx_buffer[rx_index] = '\0';
-                data_ready = 1;
-                rx_index = 0;
+    AQ_PROF_BEGIN(AQ_PROF_RX_ISR);
+    while (hal_uart1_rx_ready()) {
+        c = hal_uart1_rx_byte();
+#if AQ_LAT
+        // A frame's first byte is received one byte time after it was sent
+        if (rx_link.pos == 0 && c == AQ_LINK_SYNC) rx_sent_us = hal_micros() - RX_BYTE_US(link_baud);
+#endif
+        if (aq_link_decode_byte(&rx_link, c) != AQ_LINK_FRAME) continue;
+
+        if (rx_link.type == AQ_LINK_BAUD_REQ) {
+            link_baud_request = aq_link_get_baud(&rx_link);
+        } else if (rx_link.type == AQ_LINK_READING) {
+            frame = rx_queue_slot(&rx_frames);
+            if (!frame) {
+                rx_frames.overruns++;
+                continue;
             }
-        } else if (rx_index < sizeof(rx_buffer) - 1) {
-            rx_buffer[rx_index++] = c;
+            frame->valid = aq_link_get_reading(&rx_link, &frame->reading.co_ppm, &frame->reading.aqi,
+                                               &frame->reading.temp, &frame->reading.hum)
+                           && aq_parse_check(&aq_format_reading, &frame->reading);
+#if AQ_LAT
+            frame->stamp.sent_us = rx_sent_us;
+            frame->stamp.decoded_us = hal_micros();
+            frame->stamp.age_ms = aq_link_get_age(&rx_link);
+            frame->stamp.has_age = 1;
+#endif
+            rx_queue_publish(&rx_frames);
+            sched_signal(readings_task);
         }
     }
+    AQ_PROF_END(AQ_PROF_RX_ISR);
 }
 
-// *** IMPROVED ML PREDICTION FUNCTIONS ***
-
 /*
  * =======================================================
- * PREDICTION FUNCTION: predict_co_hazard
+ * FUNCTION: link_service
  * =======================================================
- * Features: CO PPM, Temperature, Humidity
- * Output: Hazard Score (0-100 scale)
- * 
- * Improvements:
- * - Reduced weight on CO for less sensitivity
- * - Minor environmental factor adjustments
- * - Better baseline offset
+ * Baud negotiation, a 100 ms task (the ACK and the divisor
+ * change must not happen inside the ISR).
+ * - BAUD_REQ from the Arduino: ACK it and switch
+ * - At a negotiated baud: send KEEPALIVE every second and
+ *   drop back to 9600 after 5 s without a good frame
  * =======================================================
  */
-float predict_co_hazard(int ppm, int temp_c, int hum_pct) {
-    float score;
-    
-    // Base score from CO level
-    score = ppm * CO_PPM_WEIGHT;
-    
-    // Temperature adjustment (higher temp = slightly worse)
-    score += (temp_c - 20) * CO_TEMP_WEIGHT;
-    
-    // Humidity adjustment (extreme humidity = slightly worse)
-    int hum_deviation = (hum_pct > 60) ? (hum_pct - 60) : 0;
-    score += hum_deviation * CO_HUM_WEIGHT;
-    
-    // Add bias
-    score += CO_BIAS;
-    
-    // Clamp to valid range
-    if (score < 0) score = 0;
-    if (score > 100) score = 100;
-    
-    return score;
-}
-
-/*
- * =======================================================
- * PREDICTION FUNCTION: predict_aqi_hazard
- * =======================================================
- * Features: AQI, Temperature, Humidity
- * Output: Hazard Score (0-150 scale)
- * 
- * Improvements:
- * - More reasonable AQI weight
- * - Temperature increases pollution perception
- * - Humidity has minimal effect
- * =======================================================
- */
-float predict_aqi_hazard(int aqi_val, int temp_c, int hum_pct) {
-    float score;
-    
-    // Base score from AQI
-    score = aqi_val * AQI_VAL_WEIGHT;
-    
-    // Temperature adjustment (heat makes pollution worse)
-    score += (temp_c - 20) * AQI_TEMP_WEIGHT;
-    
-    // Humidity adjustment (minimal effect)
-    score += (hum_pct - 50) * AQI_HUM_WEIGHT;
-    
-    // Add bias
-    score += AQI_BIAS;
-    
-    // Clamp to valid range
-    if (score < 0) score = 0;
-    if (score > 150) score = 150;
-    
-    return score;
-}
-
-/*
- * =======================================================
- * STATE MACHINE: update_system_state
- * =======================================================
- * Uses scores with proper hysteresis to prevent flickering
- * Buzzer pattern activates only in POOR or HAZARDOUS states
- * =======================================================
- */
-void update_system_state(float co_score, float aqi_score) {
-    enum AirQualityState previous_state = currentState;
-    
-    // Determine new state based on scores
-    if (co_score >= CO_SCORE_HAZARD_ON || aqi_score >= AQI_SCORE_HAZARD_ON) {
-        currentState = HAZARDOUS;
-    } 
-    else if (co_score >= CO_SCORE_POOR_ON || aqi_score >= AQI_SCORE_POOR_ON) {
-        currentState = POOR;
+uint8_t link_tx_seq = 0;
+uint32_t link_frames_seen = 0;
+int link_idle_ms = 0;
+int link_keepalive_ms = 0;
+
+void link_service(int elapsed_ms) {
+    uint8_t buf[AQ_LINK_MAX_FRAME];
+    uint32_t baud = link_baud_request;
+    int n;
+
+    if (baud) {
+        link_baud_request = 0;
+        if (!aq_link_baud_supported(baud)) baud = 0;    // Refuse
+        n = aq_link_encode_baud(buf, AQ_LINK_BAUD_ACK, link_tx_seq++, baud);
+        hal_uart1_write(buf, n);
+        if (baud) {
+            hal_uart1_set_baud(baud);
+            link_baud = baud;
+        }
+        link_idle_ms = 0;
+        link_keepalive_ms = 0;
     }
-    else if (co_score >= CO_SCORE_MODERATE_ON || aqi_score >= AQI_SCORE_MODERATE_ON) {
-        currentState = MODERATE;
+
+    if (rx_link.frames_ok != link_frames_seen) {
+        link_frames_seen = rx_link.frames_ok;
+        link_idle_ms = 0;
+    } else {
+        link_idle_ms += elapsed_ms;
     }
-    else {
-        currentState = GOOD;
+
+    if (link_baud == AQ_LINK_BASE_BAUD) return;
+    if (link_idle_ms >= AQ_LINK_TIMEOUT_MS) {
+        hal_uart1_set_baud(AQ_LINK_BASE_BAUD);
+        link_baud = AQ_LINK_BASE_BAUD;
+    } else if ((link_keepalive_ms += elapsed_ms) >= AQ_LINK_KEEPALIVE_MS) {
+        link_keepalive_ms = 0;
+        n = aq_link_encode(buf, AQ_LINK_KEEPALIVE, link_tx_seq++, 0, 0);
+        hal_uart1_write(buf, n);
     }
+}
+#else
+void UART1_IRQHandler(void) {
+    struct rx_frame *frame;
+    int status;
+    uint8_t seq;
+    char c;
+#if AQ_LAT
+    static int line_start = 1;
+#endif
     
-    // Hysteresis: If transitioning from POOR to MODERATE, check OFF thresholds
-    if (previous_state == POOR && currentState == MODERATE) {
-        if (co_score >= CO_SCORE_POOR_OFF || aqi_score >= AQI_SCORE_POOR_OFF) {
-            currentState = POOR; // Stay in POOR
+    AQ_PROF_BEGIN(AQ_PROF_RX_ISR);
+    while (hal_uart1_rx_ready()) {
+        c = (char)hal_uart1_rx_byte();
+#if AQ_LAT
+        // A line's first byte is received one byte time after it was sent
+        if (line_start && c != '\r' && c != '\n') {
+            rx_sent_us = hal_micros() - RX_BYTE_US(9600);
+            line_start = 0;
         }
+#endif
+        status = aq_parse_byte(&rx_parser, c);
+        if (status == AQ_PARSE_MORE) continue;
+#if AQ_LAT
+        line_start = 1;
+#endif
+
+        frame = rx_queue_slot(&rx_frames);
+        if (!frame) {
+            rx_frames.overruns++;
+            continue;
+        }
+        frame->valid = (status == AQ_PARSE_OK);
+        if (frame->valid) {
+            aq_parse_reading(&rx_parser, &frame->reading);
+            // Seq and age are optional: older Arduino sketches send four fields
+            if (rx_parser.line_fields > AQ_READING_SEQ) {
+                seq = (uint8_t)rx_parser.fields[AQ_READING_SEQ];
+                if (rx_have_seq) rx_lines_lost += (uint8_t)(seq - rx_seq - 1);
+                rx_seq = seq;
+                rx_have_seq = 1;
+            }
+        }
+#if AQ_LAT
+        frame->stamp.sent_us = rx_sent_us;
+        frame->stamp.decoded_us = hal_micros();
+        frame->stamp.has_age = frame->valid && rx_parser.line_fields > AQ_READING_AGE_MS;
+        frame->stamp.age_ms = frame->stamp.has_age ? (uint16_t)rx_parser.fields[AQ_READING_AGE_MS] : 0;
+#endif
+        rx_queue_publish(&rx_frames);
+        sched_signal(readings_task);
     }
-    
-    // Buzzer control - Enable pattern for POOR and HAZARDOUS only
-    if (currentState == POOR || currentState == HAZARDOUS) {
-        buzzer_enabled = 1;
-    } else {
-        buzzer_enabled = 0;
-        LPC_GPIO0->FIOCLR = BUZZER; // Ensure buzzer is OFF
-    }
+    AQ_PROF_END(AQ_PROF_RX_ISR);
 }
+#endif
 
 /*
  * =======================================================
- * FUNCTION: update_buzzer_pattern
+ * STATE MACHINE: update_system_state
  * =======================================================
- * Creates a beeping pattern: ON for 100ms, OFF for 100ms
- * Call this function every loop iteration (every 100ms)
+ * Filters, scores and one table lookup per reading
+ * (aq_pipeline.h); aq_replay runs the same code on traces
+ * Alarm pattern plays only in POOR or HAZARDOUS states
+ * Returns 1 if the buzzer changed pattern
  * =======================================================
  */
-void update_buzzer_pattern(void) {
-    if (!buzzer_enabled) {
-        return; // Do nothing if buzzer is disabled
-    }
-    
-    buzzer_counter++;
-    if (buzzer_counter >= BUZZER_PATTERN_TOTAL) {
-        buzzer_counter = 0; // Reset counter
-    }
+int update_system_state(const struct aq_reading *r) {
+    currentState = aq_pipeline_step(&pipeline, r);
     
-    // Turn buzzer ON for first half of pattern, OFF for second half
-    if (buzzer_counter < BUZZER_ON_TIME) {
-        LPC_GPIO0->FIOSET = BUZZER;
+    // Buzzer control - TIM3 plays the pattern, a repeat post is a no-op
+    if (currentState == HAZARDOUS) {
+        return alarm_play(ALARM_HAZARD);
+    } else if (currentState == POOR) {
+        return alarm_play(ALARM_POOR);
     } else {
-        LPC_GPIO0->FIOCLR = BUZZER;
+        return alarm_play(ALARM_OFF);
     }
 }
 
-// --- Display Modes ---
+// --- Display Modes (drawn into the framebuffer) ---
 void display_mode_1(void) {
-    lcd_command(0x80);
-    sprintf(lcdBuffer, "CO:%3dppm       ", co_ppm); 
-    lcd_string(lcdBuffer);
-
-    lcd_command(0xC0);
-    sprintf(lcdBuffer, "AQI:%3d         ", aqi); 
-    lcd_string(lcdBuffer);
+    char *p;
+
+    p = fmt_str(lcdBuffer, "CO:");
+    p = fmt_dec(p, co_ppm, 3);
+    p = fmt_str(p, "ppm       ");
+    *p = '\0';
+    lcd_fb_puts(0, 0, lcdBuffer);
+
+    p = fmt_str(lcdBuffer, "AQI:");
+    p = fmt_dec(p, aqi, 3);
+    p = fmt_str(p, "         ");
+    *p = '\0';
+    lcd_fb_puts(1, 0, lcdBuffer);
 }
 
 void display_mode_2(void) {
-    lcd_command(0x80);
-    sprintf(lcdBuffer, "Status:%-8s", stateNames[currentState]);
-    lcd_string(lcdBuffer);
+    char *p;
+
+    p = fmt_str(lcdBuffer, "Status:");
+    p = fmt_str_left(p, stateNames[currentState], 8);
+    *p = '\0';
+    lcd_fb_puts(0, 0, lcdBuffer);
 
-    lcd_command(0xC0);
     switch(currentState) {
-        case GOOD:     lcd_string("Air is Clean!   "); break;
-        case MODERATE: lcd_string("Acceptable Air  "); break;
-        case POOR:     lcd_string("Sensitive Alert!"); break;
-        case HAZARDOUS:lcd_string("Seek Fresh Air! "); break;
-        default:       lcd_string("Monitoring...   "); break;
+        case GOOD:     lcd_fb_puts(1, 0, "Air is Clean!   "); break;
+        case MODERATE: lcd_fb_puts(1, 0, "Acceptable Air  "); break;
+        case POOR:     lcd_fb_puts(1, 0, "Sensitive Alert!"); break;
+        case HAZARDOUS:lcd_fb_puts(1, 0, "Seek Fresh Air! "); break;
+        default:       lcd_fb_puts(1, 0, "Monitoring...   "); break;
     }
 }
 
 void display_mode_3(void) {
     int co_percent = (co_ppm * 100) / CO_MAX_PPM;
     int aq_percent = (aqi * 100) / AQI_MAX;   
+    char *p;
     
     if (co_percent > 100) co_percent = 100;
     if (aq_percent > 100) aq_percent = 100;
 
-    lcd_command(0x80);
-    sprintf(lcdBuffer, "CO Level: %3d%%  ", co_percent);
-    lcd_string(lcdBuffer);
-
-    lcd_command(0xC0);
-    sprintf(lcdBuffer, "AQ Level: %3d%%  ", aq_percent);
-    lcd_string(lcdBuffer);
+    p = fmt_str(lcdBuffer, "CO Level: ");
+    p = fmt_percent(p, co_percent, 3);
+    p = fmt_str(p, "  ");
+    *p = '\0';
+    lcd_fb_puts(0, 0, lcdBuffer);
+
+    p = fmt_str(lcdBuffer, "AQ Level: ");
+    p = fmt_percent(p, aq_percent, 3);
+    p = fmt_str(p, "  ");
+    *p = '\0';
+    lcd_fb_puts(1, 0, lcdBuffer);
 }
 
 void display_mode_4(void) {
-    lcd_command(0x80);
-    sprintf(lcdBuffer, "T:%2d\xDF""C  H:%2d%% ", temp, hum);
-    lcd_string(lcdBuffer);
-
-    lcd_command(0xC0);
-    if (hum < 30)       lcd_string("Dry             ");
-    else if (hum <=60)  lcd_string("Feels Good      ");
-    else                lcd_string("Humid           ");
+    char *p;
+
+    p = fmt_str(lcdBuffer, "T:");
+    p = fmt_degrees(p, temp, 2);
+    p = fmt_str(p, "  H:");
+    p = fmt_percent(p, hum, 2);
+    *p++ = ' ';
+    *p = '\0';
+    lcd_fb_puts(0, 0, lcdBuffer);
+
+    if (hum < 30)       lcd_fb_puts(1, 0, "Dry             ");
+    else if (hum <=60)  lcd_fb_puts(1, 0, "Feels Good      ");
+    else                lcd_fb_puts(1, 0, "Humid           ");
 }
 
-// --- Main ---
-int main(void) {
-    int update_counter = 0;
-    float co_hazard_score;
-    float aqi_hazard_score;
-    
-    SystemInit();
-    SystemCoreClockUpdate();
-    initTimer0();
-    lcd_init();
-    init_uart1();
-
-    LPC_GPIO0->FIODIR |= BUZZER;
-    LPC_GPIO0->FIOCLR = BUZZER;
-
-    lcd_command(0x80); lcd_string("Air Quality Mon.");
-    lcd_command(0xC0); lcd_string("Initializing...");
-    delayMS(2000);
-
-    while (1) {
-        if (data_ready) {
-            data_ready = 0;
-
-            if (sscanf(rx_buffer, "%d,%d,%d,%d", &co_ppm, &aqi, &temp, &hum) == 4) {
-                
-                // Calculate hazard scores using ML model
-                co_hazard_score = predict_co_hazard(co_ppm, temp, hum);
-                aqi_hazard_score = predict_aqi_hazard(aqi, temp, hum);
-                
-                // Update system state based on scores
-                update_system_state(co_hazard_score, aqi_hazard_score);
-
-                // Update display cycle every 5 readings
-                update_counter++;
-                if (update_counter >= 5) {
-                    update_counter = 0;
-                    display_cycle = (display_cycle + 1) % 4;  
+// --- Tasks ---
+// Signalled by UART1_IRQHandler for every frame queued
+void task_readings(void) {
+    static int update_counter = 0;
+    static int log_counter = 0;
+    enum AirQualityState previous_state;
+    struct aq_reading reading;
+    const struct rx_frame *frame;
+    int valid;
+#if AQ_LAT
+    struct aq_lat_stamp stamp;
+    uint32_t taken_us, state_us;
+    int alarm_changed, skip_lat;
+#endif
+
+    if (!splash_done) return;   // Frames wait in the queue
+
+    while ((frame = rx_queue_peek(&rx_frames)) != 0) {
+        AQ_PROF_BEGIN(AQ_PROF_READINGS);
+        valid = frame->valid;
+        if (valid) {
+            reading = frame->reading;
+            co_ppm = reading.co_ppm;
+            aqi = reading.aqi;
+            temp = reading.temp;
+            hum = reading.hum;
+        }
+#if AQ_LAT
+        stamp = frame->stamp;
+        taken_us = hal_micros();
+        skip_lat = lat_skip != 0;
+        if (skip_lat) lat_skip--;
+#endif
+        rx_queue_pop(&rx_frames);
+
+        sensor_error = !valid;
+        if (valid) {
+            // Update system state from the filtered, scored reading
+            previous_state = currentState;
+#if AQ_LAT
+            alarm_changed = update_system_state(&reading);
+            state_us = hal_micros();
+            if (!skip_lat) aq_lat_reading(&stamp, taken_us, state_us, alarm_changed);
+            lat_state_us = state_us;
+            lat_display_pending = 1;
+#else
+            update_system_state(&reading);
+#endif
+
+            if (currentState != previous_state &&
+                aq_log_append(AQ_LOG_STATE, currentState, co_ppm, aqi, temp, hum)) {
+                sched_signal(log_task);
+            }
+            if (++log_counter >= LOG_EVERY) {
+                log_counter = 0;
+                if (aq_log_append(AQ_LOG_READING, currentState, aq_filter_max(&pipeline.co),
+                                  aq_filter_max(&pipeline.aqi), temp, hum)) {
+                    sched_signal(log_task);
                 }
+            }
 
-                // Show appropriate display mode
-                switch(display_cycle) {
-                    case 0: display_mode_1(); break;
-                    case 1: display_mode_2(); break;
-                    case 2: display_mode_3(); break;
-                    case 3: display_mode_4(); break;
-                }
-            } else {
-                lcd_command(0x80); lcd_string("Sensor Error    ");
-                lcd_command(0xC0); lcd_string("Check Connection");
+            // Update display cycle every 5 readings
+            update_counter++;
+            if (update_counter >= 5) {
+                update_counter = 0;
+                display_cycle = (display_cycle + 1) % 4;
             }
         }
-        
-        // Update buzzer pattern every loop iteration
-        update_buzzer_pattern();
-        
-        delayMS(100);
+        sched_signal(display_task);
+        AQ_PROF_END(AQ_PROF_READINGS);
     }
 }
+
+void task_display(void) {
+    AQ_PROF_BEGIN(AQ_PROF_DISPLAY);
+    if (sensor_error) {
+        lcd_fb_puts(0, 0, "Sensor Error    ");
+        lcd_fb_puts(1, 0, "Check Connection");
+    } else {
+        switch(display_cycle) {
+            case 0: display_mode_1(); break;
+            case 1: display_mode_2(); break;
+            case 2: display_mode_3(); break;
+            case 3: display_mode_4(); break;
+        }
+    }
+    lcd_fb_flush();     // Only the cells that changed
+    AQ_PROF_END(AQ_PROF_DISPLAY);
+#if AQ_LAT
+    if (lat_display_pending) {
+        lat_display_pending = 0;
+        aq_lat_add(AQ_LAT_DISPLAY, hal_micros() - lat_state_us);
+    }
+#endif
+}
+
+// Signalled when a log page is full; programs it between readings
+void task_log(void) {
+    AQ_PROF_BEGIN(AQ_PROF_LOG);
+    aq_log_flush();
+    AQ_PROF_END(AQ_PROF_LOG);
+}
+
+// One-shot: end of the start-up screen
+void task_splash(void) {
+#if AQ_LAT
+    // Frames queued by now spent the splash in the queue: leave them out
+    // of the latencies rather than report the splash as queue time
+    lat_skip = rx_frames.tail - rx_frames.head;
+#endif
+    splash_done = 1;
+    sched_signal(readings_task);
+}
+
+#if AQ_LINK_PROTOCOL
+void task_link(void) {
+    link_service(100);
+}
+#endif
+
+#if AQ_PROF || AQ_LAT
+// UART0 debug port: 'p' dumps the stage timings (aq_prof.h) and the
+// latencies (aq_lat.h), 'r' clears them. One line per run, so readings
+// and the display wait for a line at most.
+#define DEBUG_BAUD  57600       // 0.5% divisor error at 25 MHz PCLK
+volatile uint8_t debug_command; // Set by the UART0 ISR
+
+void debug_rx(uint8_t c) {
+    if (c == 'p' || c == 'r') {
+        debug_command = c;
+        sched_signal(debug_task);
+    }
+}
+
+#if AQ_LAT
+// Readings the Arduino sent that never arrived (gaps in its seq)
+static uint32_t rx_lost(void) {
+#if AQ_LINK_PROTOCOL
+    return rx_link.frames_lost;
+#else
+    return rx_lines_lost;
+#endif
+}
+#endif
+
+// Line n of the dump: the aq_prof lines, then the aq_lat lines
+int debug_format(char *line, int n) {
+#if AQ_PROF
+    if (n <= AQ_PROF_N) return aq_prof_format(line, n);
+    n -= AQ_PROF_N + 1;
+#endif
+#if AQ_LAT
+    return aq_lat_format(line, n, rx_lost() - lat_lost_base);
+#else
+    return 0;
+#endif
+}
+
+void task_debug(void) {
+    static char line[AQ_PROF_LINE_MAX > AQ_LAT_LINE_MAX ? AQ_PROF_LINE_MAX : AQ_LAT_LINE_MAX];
+    static int next_line = -1;  // -1: no dump in progress
+    uint8_t command = debug_command;
+    int n;
+
+    debug_command = 0;
+    if (command == 'r') {
+#if AQ_PROF
+        aq_prof_reset();
+#endif
+#if AQ_LAT
+        aq_lat_reset();
+        lat_lost_base = rx_lost();
+#endif
+    }
+    if (command == 'p' && next_line < 0) next_line = 0;
+    if (next_line < 0) return;
+
+    n = debug_format(line, next_line++);
+    if (n) {
+        hal_uart0_write((const uint8_t *)line, n);
+        sched_signal(debug_task);
+    } else {
+        next_line = -1;
+    }
+}
+#endif
+
+// --- Main ---
+int main(void) {
+    int i;
+    
+    hal_init();
+    lcd_init();
+    for (i = 0; i < 5; i++) lcd_create_char(i, bar_chars[i]);
+
+    readings_task = sched_add(task_readings);
+    display_task = sched_add(task_display);
+    splash_task = sched_add(task_splash);
+    log_task = sched_add(task_log);
+#if AQ_LINK_PROTOCOL
+    link_task = sched_add(task_link);
+#endif
+#if AQ_PROF || AQ_LAT
+    debug_task = sched_add(task_debug);
+    hal_uart0_init(DEBUG_BAUD, debug_rx);
+#endif
+#if AQ_PROF
+    aq_prof_init();
+#endif
+#if AQ_LAT
+    aq_lat_init();
+#endif
+
+#if AQ_LINK_PROTOCOL
+    aq_link_decoder_init(&rx_link);
+    hal_uart1_init(AQ_LINK_BASE_BAUD);
+#else
+    aq_parse_init(&rx_parser, &aq_format_reading);
+    hal_uart1_init(9600);
+#endif
+    aq_model_init();
+    aq_pipeline_init(&pipeline);
+    aq_log_init();
+
+    alarm_init();
+
+    lcd_fb_init();
+    lcd_fb_puts(0, 0, "Air Quality Mon.");
+    lcd_fb_puts(1, 0, "Initializing...");
+    lcd_fb_flush();
+
+    sched_after(splash_task, 2000);
+#if AQ_LINK_PROTOCOL
+    sched_every(link_task, 100);
+#endif
+    sched_run();
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * ==========================================================================
+ * fmt.c - Fixed-width integer formatting without printf
+ * ==========================================================================
+ */
+
+#include "fmt.h"
+
+// u / 10 by reciprocal multiply: 32-bit for readings (< 81920), 64-bit above
+static uint32_t fmt_div10(uint32_t u) {
+    if (u < 81920) return (u * 52429u) >> 19;
+    return (uint32_t)(((uint64_t)u * 0xCCCCCCCDu) >> 35);
+}
+
+// Digits of v (with '-') into the end of buf; returns the first character
+static char *fmt_digits(char *end, int32_t v) {
+    uint32_t u = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+    uint32_t q;
+    char *p = end;
+
+    do {
+        q = fmt_div10(u);
+        *--p = '0' + (char)(u - q * 10);
+        u = q;
+    } while (u);
+    if (v < 0) *--p = '-';
+    return p;
+}
+
+char *fmt_str(char *p, const char *s) {
+    while (*s) *p++ = *s++;
+    return p;
+}
+
+char *fmt_fill(char *p, char c, int n) {
+    while (n-- > 0) *p++ = c;
+    return p;
+}
+
+char *fmt_str_left(char *p, const char *s, int width) {
+    while (*s) {
+        *p++ = *s++;
+        width--;
+    }
+    return fmt_fill(p, ' ', width);
+}
+
+char *fmt_dec(char *p, int32_t v, int width) {
+    char buf[11];
+    char *d = fmt_digits(buf + sizeof(buf), v);
+
+    p = fmt_fill(p, ' ', width - (int)(buf + sizeof(buf) - d));
+    while (d < buf + sizeof(buf)) *p++ = *d++;
+    return p;
+}
+
+char *fmt_dec_left(char *p, int32_t v, int width) {
+    char buf[11];
+    char *d = fmt_digits(buf + sizeof(buf), v);
+
+    width -= (int)(buf + sizeof(buf) - d);
+    while (d < buf + sizeof(buf)) *p++ = *d++;
+    return fmt_fill(p, ' ', width);
+}
+
+char *fmt_percent(char *p, int32_t v, int width) {
+    p = fmt_dec(p, v, width);
+    *p++ = '%';
+    return p;
+}
+
+char *fmt_degrees(char *p, int32_t v, int width) {
+    p = fmt_dec(p, v, width);
+    *p++ = FMT_DEGREE;
+    *p++ = 'C';
+    return p;
+}
@@ -0,0 +1,35 @@
+/*
+ * ==========================================================================
+ * fmt.h - Fixed-width integer formatting without printf
+ * ==========================================================================
+ * Each call writes one field at p and returns the position after it, so
+ * a line is built by chaining calls:
+ *
+ *     p = fmt_str(line, "CO:");
+ *     p = fmt_dec(p, co_ppm, 3);          // "%3d"
+ *     p = fmt_str(p, "ppm");
+ *     *p = '\0';
+ *
+ * Widths are minimums, as in printf: a wider number is never cut.
+ * Nothing is NUL-terminated except by the caller. Division by 10 is a
+ * reciprocal multiply, so no divide instruction or library call is used.
+ * ==========================================================================
+ */
+
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+#define FMT_DEGREE  '\xDF'      // Degree sign in the HD44780 ROM
+
+char *fmt_str(char *p, const char *s);
+char *fmt_str_left(char *p, const char *s, int width);     // "%-Ns"
+char *fmt_fill(char *p, char c, int n);
+
+char *fmt_dec(char *p, int32_t v, int width);               // "%Nd"
+char *fmt_dec_left(char *p, int32_t v, int width);          // "%-Nd"
+char *fmt_percent(char *p, int32_t v, int width);           // "%Nd%%"
+char *fmt_degrees(char *p, int32_t v, int width);           // "%Nd" + degree + "C"
+
+#endif // FMT_H
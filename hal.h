@@ -0,0 +1,121 @@
+/*
+ * ==========================================================================
+ * hal.h - Hardware abstraction layer for the air quality firmware
+ * ==========================================================================
+ * The firmware talks to the board only through these calls:
+ *   - GPIO port 0 (LCD lines), the buzzer match output (TIM3)
+ *   - microsecond delays (Timer0), a one-shot timer interrupt (TIM1),
+ *     the 1 ms tick (SysTick) and a microsecond clock (TIM3)
+ *   - sleep (WFI)
+ *   - UART1 to and from the Arduino, UART0 to the debug port
+ *   - the flash log sectors (IAP)
+ *   - a free-running cycle counter (DWT), for profiling
+ *
+ * hal_lpc1768.c implements them on the ALS board. hal_sim.c implements
+ * them on Linux with a virtual clock, for fast regression runs.
+ * hal_image.c implements only the flash log, over an image file, for
+ * host tools that read a log (aq_replay -F).
+ * ==========================================================================
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// --- Memory barrier ---
+// Orders memory accesses shared between an ISR and the main loop
+#if defined(__CC_ARM)
+#define HAL_BARRIER()   __dmb(0xF)
+#else
+#define HAL_BARRIER()   __sync_synchronize()
+#endif
+
+// --- System ---
+// Clock set-up, the delay timer and the 1 ms tick
+void hal_init(void);
+
+// --- GPIO (port 0) ---
+void hal_gpio_dir_out(uint32_t mask);
+void hal_gpio_set(uint32_t mask);
+void hal_gpio_clr(uint32_t mask);
+
+// --- Delays ---
+void hal_delay_us(unsigned int us);
+void hal_delay_ms(unsigned int ms);
+
+// --- One-shot timer (TIM1) ---
+// fn runs in interrupt context, once per hal_timer1_start()
+void hal_timer1_init(void (*fn)(void));
+void hal_timer1_start(uint32_t us);
+
+// --- Buzzer timer (TIM3; its MAT3.1 output is the buzzer pin P0.11) ---
+// Edges are made by the match hardware, not by software, so they land
+// exactly where scheduled. fn runs in interrupt context after each edge.
+void hal_buzzer_init(void (*fn)(void));
+// Drive the pin now and cancel any scheduled edge
+void hal_buzzer_set(int on);
+// Drive the pin to on, delay_us after the previous edge
+void hal_buzzer_edge(uint32_t delay_us, int on);
+
+// --- System tick (1 ms) ---
+uint32_t hal_millis(void);
+
+// --- Microsecond clock ---
+// TIM3's counter, free-running at 1 MHz from hal_init() (the buzzer's
+// match register compares against it). Wraps after 71 minutes.
+uint32_t hal_micros(void);
+
+// --- Idle ---
+// Sleep until the next interrupt (wakes even while interrupts are masked)
+void hal_idle(void);
+void hal_irq_disable(void);
+void hal_irq_enable(void);
+
+// --- UART1 (Arduino link, 8-N-1, receive interrupt) ---
+void hal_uart1_init(uint32_t baud);
+int hal_uart1_rx_ready(void);
+uint8_t hal_uart1_rx_byte(void);
+void hal_uart1_write(const uint8_t *data, int len);
+// Waits for the transmitter to drain, then changes the divisor
+void hal_uart1_set_baud(uint32_t baud);
+
+// --- UART0 (debug port, 8-N-1) ---
+// fn runs in interrupt context for every byte received. Writes wait for
+// room in the transmitter: keep them to a line at a time.
+void hal_uart0_init(uint32_t baud, void (*fn)(uint8_t c));
+void hal_uart0_write(const uint8_t *data, int len);
+
+// --- Flash log area (IAP; sectors 26-29 of the LPC1768, 32 KB each) ---
+// Read directly through hal_flash_log_base(). Erase and program run with
+// interrupts off (the flash cannot be read meanwhile): about 100 ms per
+// sector erase, 1 ms per page. UART bytes wait in the 16-byte FIFO.
+#define HAL_FLASH_SECTOR_SIZE   32768
+#define HAL_FLASH_LOG_SECTORS   4
+#define HAL_FLASH_PAGE_SIZE     256     // Smallest IAP write
+
+const uint8_t *hal_flash_log_base(void);
+// sector: 0 .. HAL_FLASH_LOG_SECTORS-1; returns 0 on success
+int hal_flash_erase(int sector);
+// One page at a page-aligned offset into the log area, from a
+// word-aligned RAM buffer; returns 0 on success
+int hal_flash_program(uint32_t offset, const void *page);
+
+// --- Cycle counter (aq_prof.h) ---
+// HAL_CYCLES() reads a free-running 32-bit counter: on the Cortex-M3 the
+// DWT CYCCNT register, core clock cycles in one load; on the host a
+// monotonic clock in ns. Differences are exact across a wrap.
+#if defined(__ARM_ARCH_7M__) || defined(__TARGET_ARCH_7_M)
+#define HAL_CYCLES()        (*(volatile uint32_t *)0xE0001004)     // DWT_CYCCNT
+#define HAL_CYCLES_UNIT     "cyc"
+#else
+uint32_t hal_cycles(void);
+#define HAL_CYCLES()        hal_cycles()
+#define HAL_CYCLES_UNIT     "ns"
+#endif
+void hal_cycles_init(void);
+
+// Receive interrupt handler, provided by the application
+void UART1_IRQHandler(void);
+
+#endif // HAL_H
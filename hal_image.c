@@ -0,0 +1,60 @@
+/*
+ * ==========================================================================
+ * hal_image.c - Flash log HAL over an image file, for host tools
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hal_image.h"
+
+#define IMAGE_SIZE  (HAL_FLASH_LOG_SECTORS * HAL_FLASH_SECTOR_SIZE)
+
+static const uint8_t *image;
+
+int hal_image_open(const char *path) {
+    struct stat st;
+    void *p;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (st.st_size != IMAGE_SIZE) {
+        fprintf(stderr, "%s: not a flash log image (%d bytes expected)\n", path, IMAGE_SIZE);
+        close(fd);
+        return -1;
+    }
+    p = mmap(0, IMAGE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    image = p;
+    return 0;
+}
+
+const uint8_t *hal_flash_log_base(void) {
+    return image;
+}
+
+int hal_flash_erase(int sector) {
+    (void)sector;
+    return -1;
+}
+
+int hal_flash_program(uint32_t offset, const void *page) {
+    (void)offset;
+    (void)page;
+    return -1;
+}
+
+uint32_t hal_millis(void) {
+    return 0;
+}
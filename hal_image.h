@@ -0,0 +1,21 @@
+/*
+ * ==========================================================================
+ * hal_image.h - Flash log HAL over an image file, for host tools
+ * ==========================================================================
+ * Just enough of hal.h for aq_log.c to read a flash log image on the build
+ * machine: one written by aq_sim -F, or read back from the board. The
+ * image is mapped read-only, so erase and program fail, and the clock
+ * stands still: aq_log_time() is the last record's time plus one.
+ * ==========================================================================
+ */
+
+#ifndef HAL_IMAGE_H
+#define HAL_IMAGE_H
+
+#include "hal.h"
+
+// Map the image (HAL_FLASH_LOG_SECTORS sectors); 0 on success, otherwise
+// the reason has been printed to stderr
+int hal_image_open(const char *path);
+
+#endif // HAL_IMAGE_H
@@ -0,0 +1,299 @@
+/*
+ * ==========================================================================
+ * hal_lpc1768.c - HAL for the LPC1768 on the ALS board
+ * ==========================================================================
+ */
+
+#include <LPC17xx.h>
+#include "hal.h"
+
+// --- System / Timer0 / SysTick ---
+void hal_init(void) {
+    uint32_t pclk;
+
+    SystemInit();
+    SystemCoreClockUpdate();
+
+    LPC_SC->PCONP |= (1 << 1);              // Power on Timer0
+    pclk = SystemCoreClock / 4;
+    LPC_TIM0->CTCR = 0x0;                   // Timer mode
+    LPC_TIM0->PR = (pclk / 1000000) - 1;    // 1 MHz tick
+    LPC_TIM0->TCR = 0x02;                   // Reset timer
+
+    LPC_SC->PCONP |= (1 << 23);             // Power on Timer3
+    LPC_TIM3->CTCR = 0x0;
+    LPC_TIM3->PR = (pclk / 1000000) - 1;    // 1 MHz tick
+    LPC_TIM3->MCR = 0;
+    LPC_TIM3->TCR = 0x02;
+    LPC_TIM3->TCR = 0x01;                   // Free-running: hal_micros()
+
+    SysTick_Config(SystemCoreClock / 1000); // 1 ms tick
+}
+
+// --- TIM1 one-shot ---
+static void (*timer1_fn)(void) = 0;
+
+void hal_timer1_init(void (*fn)(void)) {
+    uint32_t pclk = SystemCoreClock / 4;
+
+    timer1_fn = fn;
+    LPC_SC->PCONP |= (1 << 2);              // Power on Timer1
+    LPC_TIM1->CTCR = 0x0;
+    LPC_TIM1->PR = (pclk / 1000000) - 1;    // 1 MHz tick
+    LPC_TIM1->MCR = 0x07;                   // MR0: interrupt, reset, stop
+    NVIC_EnableIRQ(TIMER1_IRQn);
+}
+
+void hal_timer1_start(uint32_t us) {
+    LPC_TIM1->TCR = 0x02;                   // Reset
+    LPC_TIM1->MR0 = us ? us : 1;
+    LPC_TIM1->TCR = 0x01;                   // Start
+}
+
+void TIMER1_IRQHandler(void) {
+    LPC_TIM1->IR = 0x01;                    // Clear MR0 interrupt
+    if (timer1_fn) timer1_fn();
+}
+
+// --- TIM3 buzzer (MAT3.1 on P0.11) ---
+static void (*buzzer_fn)(void) = 0;
+static uint32_t buzzer_edge_at = 0;         // TC of the last edge
+
+// TIM3 itself runs from hal_init()
+void hal_buzzer_init(void (*fn)(void)) {
+    buzzer_fn = fn;
+    LPC_PINCON->PINSEL0 |= (3 << 22);       // P0.11 = MAT3.1
+    LPC_TIM3->EMR = 0;                      // MAT3.1 low
+    NVIC_EnableIRQ(TIMER3_IRQn);
+}
+
+void hal_buzzer_set(int on) {
+    LPC_TIM3->MCR &= ~(1 << 3);             // No MR1 interrupt
+    LPC_TIM3->EMR = on ? (1 << 1) : 0;      // EM1 = level, EMC1 = do nothing
+    buzzer_edge_at = LPC_TIM3->TC;
+}
+
+void hal_buzzer_edge(uint32_t delay_us, int on) {
+    buzzer_edge_at += delay_us;
+    // Already past (this interrupt was held off by an IAP erase): the
+    // match would wait for TC to wrap, so the step starts from now
+    if ((int32_t)(buzzer_edge_at - LPC_TIM3->TC) <= 0) buzzer_edge_at = LPC_TIM3->TC + delay_us;
+    LPC_TIM3->MR1 = buzzer_edge_at;
+    // EMC1: 1 = clear, 2 = set MAT3.1 on the MR1 match
+    LPC_TIM3->EMR = (LPC_TIM3->EMR & (1 << 1)) | ((on ? 2 : 1) << 6);
+    LPC_TIM3->MCR |= (1 << 3);              // MR1 interrupt
+}
+
+void TIMER3_IRQHandler(void) {
+    LPC_TIM3->IR = (1 << 1);                // Clear MR1 interrupt
+    if (buzzer_fn) buzzer_fn();
+}
+
+// --- System tick ---
+static volatile uint32_t hal_ms = 0;
+
+void SysTick_Handler(void) {
+    hal_ms++;
+}
+
+uint32_t hal_millis(void) {
+    return hal_ms;
+}
+
+uint32_t hal_micros(void) {
+    return LPC_TIM3->TC;
+}
+
+// --- GPIO ---
+void hal_gpio_dir_out(uint32_t mask) {
+    LPC_GPIO0->FIODIR |= mask;
+}
+
+void hal_gpio_set(uint32_t mask) {
+    LPC_GPIO0->FIOSET = mask;
+}
+
+void hal_gpio_clr(uint32_t mask) {
+    LPC_GPIO0->FIOCLR = mask;
+}
+
+// --- Delays ---
+void hal_delay_us(unsigned int us) {
+    LPC_TIM0->TCR = 0x02;
+    LPC_TIM0->TC = 0;
+    LPC_TIM0->TCR = 0x01;
+    while (LPC_TIM0->TC < us);
+    LPC_TIM0->TCR = 0x00;
+}
+
+void hal_delay_ms(unsigned int ms) {
+    while (ms--) hal_delay_us(1000);
+}
+
+// --- Idle ---
+void hal_idle(void) {
+    __WFI();
+}
+
+void hal_irq_disable(void) {
+    __disable_irq();
+}
+
+void hal_irq_enable(void) {
+    __enable_irq();
+}
+
+// --- UART1 ---
+static void uart1_set_divisor(uint32_t baud) {
+    uint32_t pclk = SystemCoreClock / 4;
+    uint16_t divisor = pclk / (16 * baud);
+
+    LPC_UART1->LCR = 0x83;                  // 8-N-1, enable DLAB
+    LPC_UART1->DLL = divisor & 0xFF;
+    LPC_UART1->DLM = (divisor >> 8) & 0xFF;
+    LPC_UART1->LCR = 0x03;                  // Disable DLAB
+}
+
+void hal_uart1_init(uint32_t baud) {
+    LPC_SC->PCONP |= (1 << 4);              // Power on UART1
+    LPC_PINCON->PINSEL0 |= (1 << 30);       // P0.15 = TXD1
+    LPC_PINCON->PINSEL1 |= (1 << 0);        // P0.16 = RXD1
+    uart1_set_divisor(baud);
+    LPC_UART1->FCR = 0x07;                  // Enable and reset FIFOs
+    LPC_UART1->IER = (1 << 0);              // RX data interrupt
+    NVIC_EnableIRQ(UART1_IRQn);
+}
+
+int hal_uart1_rx_ready(void) {
+    return LPC_UART1->LSR & 0x01;
+}
+
+uint8_t hal_uart1_rx_byte(void) {
+    return LPC_UART1->RBR;
+}
+
+void hal_uart1_write(const uint8_t *data, int len) {
+    while (len--) {
+        while (!(LPC_UART1->LSR & (1 << 5)));   // THR empty
+        LPC_UART1->THR = *data++;
+    }
+}
+
+void hal_uart1_set_baud(uint32_t baud) {
+    while (!(LPC_UART1->LSR & (1 << 6)));       // Transmitter empty
+    uart1_set_divisor(baud);
+}
+
+// --- UART0 (debug port, P0.2 TXD0 / P0.3 RXD0) ---
+static void (*uart0_fn)(uint8_t c) = 0;
+
+void hal_uart0_init(uint32_t baud, void (*fn)(uint8_t c)) {
+    uint32_t pclk = SystemCoreClock / 4;
+    uint16_t divisor = pclk / (16 * baud);
+
+    uart0_fn = fn;
+    LPC_SC->PCONP |= (1 << 3);              // Power on UART0
+    LPC_PINCON->PINSEL0 |= (1 << 4) | (1 << 6);
+    LPC_UART0->LCR = 0x83;                  // 8-N-1, enable DLAB
+    LPC_UART0->DLL = divisor & 0xFF;
+    LPC_UART0->DLM = (divisor >> 8) & 0xFF;
+    LPC_UART0->LCR = 0x03;
+    LPC_UART0->FCR = 0x07;
+    LPC_UART0->IER = (1 << 0);              // RX data interrupt
+    NVIC_EnableIRQ(UART0_IRQn);
+}
+
+void hal_uart0_write(const uint8_t *data, int len) {
+    while (len--) {
+        while (!(LPC_UART0->LSR & (1 << 5)));   // THR empty
+        LPC_UART0->THR = *data++;
+    }
+}
+
+void UART0_IRQHandler(void) {
+    uint8_t c;
+
+    while (LPC_UART0->LSR & 0x01) {
+        c = LPC_UART0->RBR;
+        if (uart0_fn) uart0_fn(c);
+    }
+}
+
+// --- Cycle counter (DWT) ---
+#define DEMCR           (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA    (1 << 24)
+#define DWT_CTRL        (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNTENA   (1 << 0)
+
+void hal_cycles_init(void) {
+    DEMCR |= DEMCR_TRCENA;                  // Power the DWT
+    HAL_CYCLES() = 0;
+    DWT_CTRL |= DWT_CYCCNTENA;
+}
+
+// --- Flash log area (IAP) ---
+// The IAP routines use the top 32 bytes of on-chip RAM; the linker
+// scatter file keeps the stack below them.
+#define IAP_LOCATION            0x1FFF1FF1
+#define IAP_PREPARE             50
+#define IAP_COPY_RAM_TO_FLASH   51
+#define IAP_ERASE               52
+#define FLASH_LOG_FIRST_SECTOR  26
+#define FLASH_LOG_BASE          0x00060000      // Sector 26
+
+typedef void (*iap_entry)(unsigned int *cmd, unsigned int *result);
+
+static int iap_call(unsigned int *cmd) {
+    unsigned int result[5];
+
+    ((iap_entry)IAP_LOCATION)(cmd, result);
+    return (int)result[0];                      // 0 = CMD_SUCCESS
+}
+
+static uint32_t iap_us_carry = 0;           // Sub-ms part of the time spent in IAP
+
+// Prepare, then run cmd, with interrupts off throughout. SysTick cannot
+// count while they are off (an erase is ~100 ms), so hal_ms is advanced
+// by the time TIM3 saw pass instead.
+static int iap_run(int sector, unsigned int *cmd) {
+    unsigned int prepare[3];
+    uint32_t start;
+    int err;
+
+    prepare[0] = IAP_PREPARE;
+    prepare[1] = prepare[2] = sector;
+    hal_irq_disable();
+    start = LPC_TIM3->TC;
+    err = iap_call(prepare);
+    if (!err) err = iap_call(cmd);
+    iap_us_carry += LPC_TIM3->TC - start;
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;         // The tick pended meanwhile is in the carry
+    hal_ms += iap_us_carry / 1000;
+    iap_us_carry %= 1000;
+    hal_irq_enable();
+    return err;
+}
+
+const uint8_t *hal_flash_log_base(void) {
+    return (const uint8_t *)FLASH_LOG_BASE;
+}
+
+int hal_flash_erase(int sector) {
+    unsigned int cmd[4];
+
+    cmd[0] = IAP_ERASE;
+    cmd[1] = cmd[2] = FLASH_LOG_FIRST_SECTOR + sector;
+    cmd[3] = SystemCoreClock / 1000;            // cclk in kHz
+    return iap_run(FLASH_LOG_FIRST_SECTOR + sector, cmd);
+}
+
+int hal_flash_program(uint32_t offset, const void *page) {
+    unsigned int cmd[5];
+
+    cmd[0] = IAP_COPY_RAM_TO_FLASH;
+    cmd[1] = FLASH_LOG_BASE + offset;
+    cmd[2] = (unsigned int)page;
+    cmd[3] = HAL_FLASH_PAGE_SIZE;
+    cmd[4] = SystemCoreClock / 1000;
+    return iap_run(FLASH_LOG_FIRST_SECTOR + offset / HAL_FLASH_SECTOR_SIZE, cmd);
+}
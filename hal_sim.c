@@ -0,0 +1,672 @@
+/*
+ * ==========================================================================
+ * hal_sim.c - HAL on Linux: the firmware against a virtual ALS board
+ * ==========================================================================
+ * Runs code.c (or old.c) unmodified on the build machine. Time is
+ * virtual: a delay just moves the clock forward, so an hour of 1 Hz
+ * sensor traffic replays in well under a second.
+ *
+ * The board model:
+ *   - UART1 is fed from a trace of "co,aqi,temp,hum" lines, one line per
+ *     period (the Arduino sends every 1000 ms), each byte arriving at the
+ *     baud rate set by the firmware, in the FIFO once its stop bit is in.
+ *     Every byte raises UART1_IRQHandler. Four-field readings get the
+ *     seq and capture-age fields the Arduino appends, with a fixed age.
+ *     With AQ_LINK_PROTOCOL=1 each line is sent as a binary READING frame
+ *     instead (lines that do not parse go out as raw bytes), and -B opens
+ *     the trace with a BAUD_REQ for that rate.
+ *   - The LCD lines are decoded on each EN falling edge by a small
+ *     HD44780 model (4-bit interface, DDRAM, clear/home/set address).
+ *   - The buzzer pin is watched for transitions, whether driven as GPIO
+ *     or by the TIM3 match output.
+ *   - UART0, the debug port, logs each line the firmware writes, taking
+ *     the time it takes on the wire; -P sends it a 'p' (dump request,
+ *     aq_prof.h and aq_lat.h) at the given time, and may be repeated.
+ *   - The flash log sectors are a memory-mapped file (-F), so the log
+ *     survives from one run to the next like it does across power cycles;
+ *     without -F they start erased. Erase and program take their typical
+ *     time with interrupts held off. aq_replay -F dumps an image.
+ *
+ * Output is an event log, one line per event, for diffing against a
+ * known-good run:
+ *       12.345 LCD |CO: 25ppm       |AQI:105         |
+ *       13.100 BUZZER on
+ * An LCD line is logged once the screen has been stable for 10 ms, so
+ * half-written screens never show up. Characters outside ASCII are
+ * written as \xNN. The last line is a summary.
+ *
+ * Build (the firmware's main() is renamed, this file supplies main()):
+ *     cc -O2 -Dmain=firmware_main -o aq_sim hal_sim.c lcd.c lcd_fb.c fmt.c \
+ *        aq_parse.c aq_link.c sched.c alarm.c aq_filter.c aq_pipeline.c aq_log.c \
+ *        code.c aq_model.c aq_score.c sensor_model_qs.c sensor_model_memo.c \
+ *        aq_prof.c aq_lat.c
+ * aq_prof.c and aq_lat.c are empty unless built with -DAQ_PROF=1 / -DAQ_LAT=1.
+ *     ./aq_sim [-p period_ms] [-t tail_ms] [-B baud] [-F flash.bin] [-P ms]...
+ *           [-o log.txt] trace.csv
+ * old.c builds the same way from hal_sim.c lcd.c fmt.c aq_parse.c old.c.
+ * The summary counts the bytes sent to the LCD controller (lcd_bytes).
+ * Lines of the trace starting with '#' are skipped.
+ * ==========================================================================
+ */
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hal.h"
+#include "lcd.h"
+#include "aq_link.h"
+#include "aq_parse.h"
+
+#undef main
+int firmware_main(void);
+
+#define SIM_BUZZER          (1 << 11)   // P0.11, as wired on the ALS board
+#define SIM_LCD_SETTLE_US   10000
+#define SIM_RX_FIFO         16          // LPC1768 UART receive FIFO depth
+#define SIM_FLASH_SIZE      (HAL_FLASH_LOG_SECTORS * HAL_FLASH_SECTOR_SIZE)
+#define SIM_FLASH_ERASE_US  100000      // Typical sector erase (datasheet)
+#define SIM_FLASH_PAGE_US   1000        // Typical 256-byte program
+#define SIM_UART0_REQUESTS  16
+// Arduino loop from capture to Serial.write: two readSmooth() (20 ADC
+// conversions, ~2 ms) and the DHT11 read (~25 ms)
+#define SIM_ARDUINO_AGE_MS  27
+
+// --- Virtual clock ---
+static uint64_t now_us;
+static uint64_t end_us;             // 0 until the trace is exhausted
+static uint64_t tail_us = 3000000;
+static jmp_buf sim_exit;
+
+// --- Event log ---
+static FILE *log_out;
+static unsigned long lcd_updates, lcd_bytes, buzzer_transitions;
+static uint64_t buzzer_on_us, buzzer_since_us;
+
+static void log_time(uint64_t t) {
+    fprintf(log_out, "%8llu.%03llu ",
+            (unsigned long long)(t / 1000000), (unsigned long long)(t / 1000 % 1000));
+}
+
+// --- UART1: trace playback ---
+static uint8_t *wire;               // Every message, back to back
+static size_t wire_len, wire_pos;
+static size_t *msg_end;             // wire offset just past each message
+static size_t n_msgs, msg;          // msg: message being sent
+static size_t line_start;           // wire offset of that message
+static unsigned long line_index, lines_sent;
+static uint32_t fast_baud;          // -B: open with a BAUD_REQ (binary link)
+static unsigned long tx_bytes;
+#if AQ_LINK_PROTOCOL
+static struct aq_link_decoder link_tx;  // Frames sent by the firmware
+#endif
+static uint64_t period_us = 1000000;
+static uint64_t line_us, next_byte_us;
+static uint32_t uart_baud;
+static uint8_t rx_fifo[SIM_RX_FIFO];
+static unsigned rx_head, rx_tail;
+static unsigned long rx_overruns;
+static int in_irq;
+
+static uint64_t byte_time(size_t n) {
+    return (uint64_t)n * 10 * 1000000 / uart_baud;  // 8-N-1 = 10 bits
+}
+
+static void uart_schedule(void) {
+    uint64_t t;
+
+    if (wire_pos >= wire_len) {
+        end_us = next_byte_us + tail_us;
+        next_byte_us = UINT64_MAX;
+        return;
+    }
+    if (wire_pos == msg_end[msg]) {
+        line_start = wire_pos;
+        msg++;
+        line_index++;
+    }
+    // Never faster than the line itself takes on the wire; a byte is
+    // received one byte time after it starts
+    t = line_us + line_index * period_us + byte_time(wire_pos - line_start + 1);
+    if (wire_pos > 0 && t < next_byte_us + byte_time(1)) t = next_byte_us + byte_time(1);
+    next_byte_us = t;
+}
+
+static void uart_deliver(void) {
+    if (rx_tail - rx_head < SIM_RX_FIFO) rx_fifo[rx_tail++ % SIM_RX_FIFO] = wire[wire_pos];
+    else rx_overruns++;
+    wire_pos++;
+    if (wire_pos == msg_end[msg]) lines_sent++;
+    uart_schedule();
+
+    if (!in_irq) {
+        in_irq = 1;
+        UART1_IRQHandler();
+        in_irq = 0;
+    }
+}
+
+// --- LCD: HD44780 model ---
+static struct {
+    uint8_t ddram[0x80];
+    uint8_t addr;
+    int cgram;                      // Data goes to CGRAM after a 0x40 command
+    int four_bit;
+    int have_high;
+    uint8_t high;
+    int dirty;
+    uint64_t last_write_us;
+    char shown[2][16 * 4 + 1];
+} lcd;
+
+static void lcd_render(int row, char *out) {
+    const uint8_t *p = &lcd.ddram[row ? 0x40 : 0x00];
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        if (p[i] >= 0x20 && p[i] < 0x7F) *out++ = p[i];
+        else out += sprintf(out, "\\x%02X", p[i]);
+    }
+    *out = '\0';
+}
+
+static void lcd_log_if_changed(void) {
+    char row[2][16 * 4 + 1];
+
+    lcd.dirty = 0;
+    lcd_render(0, row[0]);
+    lcd_render(1, row[1]);
+    if (!strcmp(row[0], lcd.shown[0]) && !strcmp(row[1], lcd.shown[1])) return;
+    memcpy(lcd.shown, row, sizeof(row));
+    lcd_updates++;
+    log_time(lcd.last_write_us);
+    fprintf(log_out, "LCD |%s|%s|\n", row[0], row[1]);
+}
+
+static void lcd_execute(int rs, uint8_t byte) {
+    lcd_bytes++;
+    lcd.dirty = 1;
+    lcd.last_write_us = now_us;
+    if (rs) {
+        if (lcd.cgram) return;      // Custom glyphs are not modelled
+        lcd.ddram[lcd.addr] = byte;
+        lcd.addr++;
+        if (lcd.addr == 0x28) lcd.addr = 0x40;
+        else if (lcd.addr == 0x68) lcd.addr = 0x00;
+    } else if (byte & 0x80) {
+        lcd.addr = byte & 0x7F;
+        lcd.cgram = 0;
+    } else if (byte & 0x40) {
+        lcd.cgram = 1;
+    } else if (byte & 0x20) {
+        lcd.four_bit = !(byte & 0x10);
+    } else if (byte & 0x1C) {
+        // Shift, display control, entry mode: defaults assumed
+    } else if (byte & 0x02) {
+        lcd.addr = 0;
+        lcd.cgram = 0;
+    } else if (byte & 0x01) {
+        memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+        lcd.addr = 0;
+        lcd.cgram = 0;
+    }
+}
+
+static void lcd_strobe(uint32_t pins) {
+    int rs = (pins & LCD_RS) != 0;
+    uint8_t nibble = (pins & LCD_DATA_MASK) >> 23;
+
+    if (!lcd.four_bit) {
+        // 8-bit interface: the low nibble lines are not wired
+        lcd_execute(rs, nibble << 4);
+        lcd.have_high = 0;
+    } else if (!lcd.have_high) {
+        lcd.high = nibble;
+        lcd.have_high = 1;
+    } else {
+        lcd_execute(rs, (lcd.high << 4) | nibble);
+        lcd.have_high = 0;
+    }
+}
+
+// --- TIM1 ---
+static uint64_t timer1_due_us = UINT64_MAX;
+static void (*timer1_fn)(void);
+
+void hal_timer1_init(void (*fn)(void)) {
+    timer1_fn = fn;
+}
+
+void hal_timer1_start(uint32_t us) {
+    timer1_due_us = now_us + (us ? us : 1);
+}
+
+// --- Buzzer (P0.11 as GPIO, or MAT3.1 driven by TIM3) ---
+static int buzzer_level;
+static uint64_t timer3_due_us = UINT64_MAX;     // Next scheduled edge
+static uint64_t buzzer_edge_us;                 // Time of the last edge
+static int timer3_level;
+static void (*timer3_fn)(void);
+
+static void sim_buzzer(int on) {
+    if (on == buzzer_level) return;
+    buzzer_level = on;
+    buzzer_transitions++;
+    log_time(now_us);
+    if (on) {
+        buzzer_since_us = now_us;
+        fprintf(log_out, "BUZZER on\n");
+    } else {
+        buzzer_on_us += now_us - buzzer_since_us;
+        fprintf(log_out, "BUZZER off\n");
+    }
+}
+
+void hal_buzzer_init(void (*fn)(void)) {
+    timer3_fn = fn;
+}
+
+void hal_buzzer_set(int on) {
+    timer3_due_us = UINT64_MAX;
+    buzzer_edge_us = now_us;
+    sim_buzzer(on);
+}
+
+void hal_buzzer_edge(uint32_t delay_us, int on) {
+    buzzer_edge_us += delay_us;
+    timer3_due_us = buzzer_edge_us;
+    timer3_level = on;
+}
+
+// --- UART0: debug port ---
+static void (*uart0_fn)(uint8_t c);
+static uint32_t uart0_baud;
+static uint64_t uart0_requests[SIM_UART0_REQUESTS];    // -P times, in order
+static int n_uart0_requests, uart0_request;
+static uint64_t uart0_due_us = UINT64_MAX;
+static char uart0_line[1024];
+static size_t uart0_len;
+
+static void uart0_schedule(void) {
+    uart0_due_us = uart0_fn && uart0_request < n_uart0_requests
+                   ? uart0_requests[uart0_request] : UINT64_MAX;
+}
+
+// --- Time ---
+static void sim_advance(uint64_t us);
+
+void hal_uart0_init(uint32_t baud, void (*fn)(uint8_t c)) {
+    uart0_baud = baud;
+    uart0_fn = fn;
+    uart0_schedule();
+}
+
+void hal_uart0_write(const uint8_t *data, int len) {
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (data[i] == '\n') {
+            log_time(now_us);
+            fprintf(log_out, "UART0 %.*s\n", (int)uart0_len, uart0_line);
+            uart0_len = 0;
+        } else if (data[i] != '\r' && uart0_len < sizeof(uart0_line)) {
+            uart0_line[uart0_len++] = (char)data[i];
+        }
+    }
+    // The caller waits for the transmitter
+    sim_advance((uint64_t)len * 10 * 1000000 / uart0_baud);
+}
+
+// Interrupts fire in time order; ties go to UART1, then TIM1, TIM3, UART0
+static void sim_advance(uint64_t us) {
+    uint64_t target = now_us + us;
+    uint64_t t;
+
+    for (;;) {
+        t = next_byte_us < timer1_due_us ? next_byte_us : timer1_due_us;
+        if (timer3_due_us < t) t = timer3_due_us;
+        if (uart0_due_us < t) t = uart0_due_us;
+        if (t > target) break;
+        if (t > now_us) now_us = t;
+        in_irq = 1;
+        if (t == next_byte_us) {
+            in_irq = 0;
+            uart_deliver();
+        } else if (t == timer1_due_us) {
+            timer1_due_us = UINT64_MAX;
+            timer1_fn();
+        } else if (t != timer3_due_us) {
+            uart0_request++;
+            uart0_schedule();
+            uart0_fn('p');
+        } else {
+            // The match output changes the pin, then the interrupt runs
+            timer3_due_us = UINT64_MAX;
+            sim_buzzer(timer3_level);
+            timer3_fn();
+        }
+        in_irq = 0;
+    }
+    now_us = target;
+
+    if (lcd.dirty && now_us - lcd.last_write_us >= SIM_LCD_SETTLE_US) lcd_log_if_changed();
+    if (end_us && now_us >= end_us) longjmp(sim_exit, 1);
+}
+
+// --- HAL ---
+static uint32_t gpio_dir, gpio_out;
+
+void hal_init(void) {
+}
+
+void hal_gpio_dir_out(uint32_t mask) {
+    gpio_dir |= mask;
+}
+
+static void gpio_write(uint32_t out) {
+    uint32_t changed = (gpio_out ^ out) & gpio_dir;
+
+    if ((changed & LCD_EN) && !(out & LCD_EN)) lcd_strobe(out);
+    if (changed & SIM_BUZZER) sim_buzzer((out & SIM_BUZZER) != 0);
+    gpio_out = out;
+}
+
+void hal_gpio_set(uint32_t mask) {
+    gpio_write(gpio_out | mask);
+}
+
+void hal_gpio_clr(uint32_t mask) {
+    gpio_write(gpio_out & ~mask);
+}
+
+void hal_delay_us(unsigned int us) {
+    sim_advance(us);
+}
+
+void hal_delay_ms(unsigned int ms) {
+    sim_advance((uint64_t)ms * 1000);
+}
+
+uint32_t hal_millis(void) {
+    return (uint32_t)(now_us / 1000);
+}
+
+uint32_t hal_micros(void) {
+    return (uint32_t)now_us;
+}
+
+void hal_idle(void) {
+    // Sleep until the next interrupt: the 1 ms tick, a UART byte, TIM1, TIM3
+    uint64_t wake = (now_us / 1000 + 1) * 1000;
+
+    if (next_byte_us < wake) wake = next_byte_us;
+    if (timer1_due_us < wake) wake = timer1_due_us;
+    if (timer3_due_us < wake) wake = timer3_due_us;
+    if (uart0_due_us < wake) wake = uart0_due_us;
+    sim_advance(wake - now_us);
+}
+
+// Flash busy with interrupts off: bytes still reach the FIFO (or overrun
+// it), and every interrupt that came due runs once it is over
+static void sim_irq_blocked(uint64_t us) {
+    uint64_t target = now_us + us;
+
+    in_irq = 1;
+    while (next_byte_us <= target) {
+        if (next_byte_us > now_us) now_us = next_byte_us;
+        uart_deliver();
+    }
+    in_irq = 0;
+    now_us = target;
+    if (rx_tail != rx_head) {
+        in_irq = 1;
+        UART1_IRQHandler();
+        in_irq = 0;
+    }
+    sim_advance(0);
+}
+
+// Interrupts are only raised from sim_advance(), never asynchronously
+void hal_irq_disable(void) {
+}
+
+void hal_irq_enable(void) {
+}
+
+void hal_uart1_init(uint32_t baud) {
+    uart_baud = baud;
+    line_us = now_us;
+    line_start = 0;
+    line_index = 1;                 // First line one period after start-up
+    next_byte_us = 0;
+    uart_schedule();
+}
+
+int hal_uart1_rx_ready(void) {
+    return rx_head != rx_tail;
+}
+
+uint8_t hal_uart1_rx_byte(void) {
+    if (rx_head == rx_tail) return 0;
+    return rx_fifo[rx_head++ % SIM_RX_FIFO];
+}
+
+void hal_uart1_write(const uint8_t *data, int len) {
+    // Transmit time is not modelled; the FIFO absorbs short frames
+    tx_bytes += len;
+#if AQ_LINK_PROTOCOL
+    while (len--) {
+        if (aq_link_decode_byte(&link_tx, *data++) != AQ_LINK_FRAME) continue;
+        if (link_tx.type == AQ_LINK_BAUD_ACK) {
+            log_time(now_us);
+            fprintf(log_out, "LINK ack %lu\n", (unsigned long)aq_link_get_baud(&link_tx));
+        }
+    }
+#else
+    (void)data;
+#endif
+}
+
+void hal_uart1_set_baud(uint32_t baud) {
+    // Both ends switch together; the trace keeps playing at the new rate
+    if (baud == uart_baud) return;
+    uart_baud = baud;
+    log_time(now_us);
+    fprintf(log_out, "BAUD %lu\n", (unsigned long)baud);
+}
+
+// --- Cycle counter: the host's own clock, so stages cost host time ---
+uint32_t hal_cycles(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+void hal_cycles_init(void) {
+}
+
+// --- Flash log area: a memory-mapped file (-F), or anonymous memory ---
+static uint8_t *flash;
+static unsigned long flash_erases, flash_pages;
+
+static int flash_map(const char *path) {
+    int fd, fresh;
+    struct stat st;
+
+    if (!path) {
+        flash = mmap(NULL, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (flash == MAP_FAILED) return -1;
+        memset(flash, 0xFF, SIM_FLASH_SIZE);
+        return 0;
+    }
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) != 0) return -1;
+    fresh = st.st_size != SIM_FLASH_SIZE;
+    if (fresh && ftruncate(fd, SIM_FLASH_SIZE) != 0) return -1;
+    flash = mmap(NULL, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (flash == MAP_FAILED) return -1;
+    if (fresh) memset(flash, 0xFF, SIM_FLASH_SIZE);   // As shipped: erased
+    return 0;
+}
+
+const uint8_t *hal_flash_log_base(void) {
+    return flash;
+}
+
+int hal_flash_erase(int sector) {
+    if (sector < 0 || sector >= HAL_FLASH_LOG_SECTORS) return -1;
+    memset(flash + sector * HAL_FLASH_SECTOR_SIZE, 0xFF, HAL_FLASH_SECTOR_SIZE);
+    flash_erases++;
+    sim_irq_blocked(SIM_FLASH_ERASE_US);
+    return 0;
+}
+
+int hal_flash_program(uint32_t offset, const void *page) {
+    const uint8_t *src = page;
+    int i;
+
+    if (offset % HAL_FLASH_PAGE_SIZE || offset >= SIM_FLASH_SIZE) return -1;
+    // Programming can only clear bits
+    for (i = 0; i < HAL_FLASH_PAGE_SIZE; i++) flash[offset + i] &= src[i];
+    flash_pages++;
+    sim_irq_blocked(SIM_FLASH_PAGE_US);
+    return 0;
+}
+
+// --- Trace loading ---
+static int wire_append(const void *data, size_t n) {
+    static size_t cap, msg_cap;
+
+    while (wire_len + n > cap) {
+        cap = cap ? cap * 2 : 4096;
+        wire = realloc(wire, cap);
+        if (!wire) return -1;
+    }
+    if (n_msgs == msg_cap) {
+        msg_cap = msg_cap ? msg_cap * 2 : 256;
+        msg_end = realloc(msg_end, msg_cap * sizeof(*msg_end));
+        if (!msg_end) return -1;
+    }
+    memcpy(wire + wire_len, data, n);
+    wire_len += n;
+    msg_end[n_msgs++] = wire_len;
+    return 0;
+}
+
+#if AQ_LINK_PROTOCOL
+// Encode a trace line as the Arduino would; lines that do not parse are
+// sent as raw text, which the decoder has to skip
+static int wire_append_line(const char *line, size_t n) {
+    static struct aq_parser parser;
+    static uint8_t seq;
+    struct aq_reading r;
+    uint8_t frame[AQ_LINK_MAX_FRAME];
+    int status = AQ_PARSE_MORE;
+    size_t i;
+
+    if (!parser.format) aq_parse_init(&parser, &aq_format_reading);
+    for (i = 0; i < n; i++) aq_parse_byte(&parser, line[i]);
+    status = aq_parse_byte(&parser, '\n');
+    if (status != AQ_PARSE_OK) return wire_append(line, n);
+    aq_parse_reading(&parser, &r);
+    return wire_append(frame, aq_link_encode_reading(frame, seq++, r.co_ppm, r.aqi, (int8_t)r.temp, (uint8_t)r.hum,
+                                                     SIM_ARDUINO_AGE_MS));
+}
+#else
+// Send a trace line as the Arduino would: a four-field reading gets the
+// seq and age fields, anything else goes out as it is
+static int wire_append_line(const char *line, size_t n) {
+    static struct aq_parser parser;
+    static uint8_t seq;
+    char buf[272];
+    size_t i;
+
+    if (!parser.format) aq_parse_init(&parser, &aq_format_reading);
+    for (i = 0; i < n; i++) aq_parse_byte(&parser, line[i]);
+    memcpy(buf, line, n);
+    if (aq_parse_byte(&parser, '\n') == AQ_PARSE_OK && parser.line_fields == AQ_READING_FIELDS) {
+        n += (size_t)sprintf(buf + n, ",%u,%d", (unsigned)seq++, SIM_ARDUINO_AGE_MS);
+    }
+    buf[n] = '\r';
+    buf[n + 1] = '\n';
+    return wire_append(buf, n + 2);
+}
+#endif
+
+static int load_trace(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    size_t n;
+    int err = 0;
+
+    if (!f) return -1;
+#if AQ_LINK_PROTOCOL
+    if (fast_baud) {
+        uint8_t frame[AQ_LINK_MAX_FRAME];
+        err = wire_append(frame, aq_link_encode_baud(frame, AQ_LINK_BAUD_REQ, 0xFF, fast_baud));
+    }
+#endif
+    while (!err && fgets(line, sizeof(line), f)) {
+        n = strcspn(line, "\r\n");
+        if (n == 0 || line[0] == '#') continue;
+        err = wire_append_line(line, n);
+    }
+    fclose(f);
+    return err;
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    const char *flash_path = NULL;
+
+    log_out = stdout;
+    while ((opt = getopt(argc, argv, "p:t:o:B:F:P:")) != -1) {
+        switch (opt) {
+            case 'P':
+                if (n_uart0_requests == SIM_UART0_REQUESTS) break;
+                uart0_requests[n_uart0_requests++] = strtoull(optarg, NULL, 10) * 1000;
+                break;
+            case 'F': flash_path = optarg; break;
+            case 'B': fast_baud = strtoul(optarg, NULL, 10); break;
+            case 'p': period_us = strtoull(optarg, NULL, 10) * 1000; break;
+            case 't': tail_us = strtoull(optarg, NULL, 10) * 1000; break;
+            case 'o':
+                log_out = fopen(optarg, "w");
+                if (!log_out) { perror(optarg); return 1; }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-p period_ms] [-t tail_ms] [-B baud] [-F flash.bin] [-P ms]... [-o log] trace.csv\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc || load_trace(argv[optind]) != 0) {
+        fprintf(stderr, "%s: cannot read trace\n", argc > optind ? argv[optind] : argv[0]);
+        return 1;
+    }
+    if (flash_map(flash_path) != 0) {
+        perror(flash_path ? flash_path : "mmap");
+        return 1;
+    }
+    next_byte_us = UINT64_MAX;      // Nothing arrives before hal_uart1_init()
+    memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+
+    if (!setjmp(sim_exit)) firmware_main();
+
+    if (lcd.dirty) lcd_log_if_changed();
+    if (buzzer_level) buzzer_on_us += now_us - buzzer_since_us;
+    log_time(now_us);
+    fprintf(log_out, "END lines=%lu lcd_updates=%lu lcd_bytes=%lu buzzer_transitions=%lu buzzer_on_ms=%llu rx_overruns=%lu tx_bytes=%lu flash_erases=%lu flash_pages=%lu\n",
+            lines_sent, lcd_updates, lcd_bytes, buzzer_transitions,
+            (unsigned long long)(buzzer_on_us / 1000), rx_overruns, tx_bytes,
+            flash_erases, flash_pages);
+    if (log_out != stdout) fclose(log_out);
+    return 0;
+}
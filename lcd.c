@@ -0,0 +1,159 @@
+/*
+ * ==========================================================================
+ * lcd.c - HD44780 16x2 LCD driver (4-bit mode, ALS board wiring)
+ * ==========================================================================
+ * Asynchronous: every call queues its bytes and returns. The TIM1 match
+ * interrupt clocks them out one step at a time:
+ *
+ *   RS + high nibble, EN high -> 1us -> EN low, low nibble -> 1us ->
+ *   EN high -> 1us -> EN low -> settle (40us-5ms, per command) -> next
+ *
+ * so the CPU never spins on the controller. lcd_init() and
+ * lcd_create_char() go through the same queue, power-on waits included.
+ * Only a full queue makes the caller wait (sleeping in WFI).
+ * ==========================================================================
+ */
+
+#include "hal.h"
+#include "lcd.h"
+#include "aq_prof.h"
+
+#define LCD_QUEUE_DEPTH  64     // Power of two; a full redraw is 38 ops
+
+// --- Queued operations ---
+#define LCD_OP_DATA      0x01   // RS high
+#define LCD_OP_NIBBLE    0x02   // Single nibble (init sequence)
+#define LCD_OP_WAIT      0x04   // No transfer, only the settle time
+
+struct lcd_op {
+    uint8_t byte;
+    uint8_t flags;
+    uint16_t settle_us;         // Wait after the transfer
+};
+
+static struct lcd_op lcd_queue[LCD_QUEUE_DEPTH];
+static volatile uint32_t lcd_head = 0;     // Written by the ISR only
+static volatile uint32_t lcd_tail = 0;     // Written by the caller only
+static volatile uint8_t lcd_running = 0;   // Timer chain active
+static uint8_t lcd_step = 0;
+
+uint32_t lcd_queue_waits = 0;
+
+static void lcd_put_nibble(uint8_t nibble) {
+    hal_gpio_clr(LCD_DATA_MASK);
+    hal_gpio_set((nibble & 0x0F) << 23);
+}
+
+// One step of the current operation
+static void lcd_timer_step(void) {
+    const struct lcd_op *op;
+
+    if (lcd_head == lcd_tail) {
+        lcd_running = 0;        // Settled and nothing queued
+        return;
+    }
+    op = &lcd_queue[lcd_head % LCD_QUEUE_DEPTH];
+
+    switch (lcd_step) {
+        case 0:
+            if (op->flags & LCD_OP_WAIT) break;
+            if (op->flags & LCD_OP_DATA) hal_gpio_set(LCD_RS);
+            else hal_gpio_clr(LCD_RS);
+            lcd_put_nibble((op->flags & LCD_OP_NIBBLE) ? op->byte : op->byte >> 4);
+            hal_gpio_set(LCD_EN);
+            lcd_step = 1;
+            hal_timer1_start(1);        // EN pulse must be >450ns
+            return;
+        case 1:
+            hal_gpio_clr(LCD_EN);
+            if (op->flags & LCD_OP_NIBBLE) break;
+            lcd_put_nibble(op->byte);
+            lcd_step = 2;
+            hal_timer1_start(1);
+            return;
+        case 2:
+            hal_gpio_set(LCD_EN);
+            lcd_step = 3;
+            hal_timer1_start(1);
+            return;
+        case 3:
+            hal_gpio_clr(LCD_EN);
+            break;
+    }
+
+    // Operation done: release it and wait for the controller
+    lcd_step = 0;
+    lcd_head = lcd_head + 1;
+    hal_timer1_start(op->settle_us);
+}
+
+// TIM1 match interrupt
+static void lcd_timer_tick(void) {
+    AQ_PROF_BEGIN(AQ_PROF_LCD_ISR);
+    lcd_timer_step();
+    AQ_PROF_END(AQ_PROF_LCD_ISR);
+}
+
+static void lcd_queue_op(uint8_t byte, uint8_t flags, uint16_t settle_us) {
+    struct lcd_op *op;
+
+    while (lcd_tail - lcd_head >= LCD_QUEUE_DEPTH) {
+        lcd_queue_waits++;
+        hal_idle();
+    }
+    op = &lcd_queue[lcd_tail % LCD_QUEUE_DEPTH];
+    op->byte = byte;
+    op->flags = flags;
+    op->settle_us = settle_us;
+    HAL_BARRIER();
+    lcd_tail = lcd_tail + 1;
+
+    hal_irq_disable();
+    if (!lcd_running) {
+        lcd_running = 1;
+        hal_timer1_start(1);
+    }
+    hal_irq_enable();
+}
+
+void lcd_command(unsigned char cmd) {
+    // Clear and home need 1.52ms, everything else ~40us
+    lcd_queue_op(cmd, 0, (cmd <= 0x03) ? 2000 : 50);
+}
+
+void lcd_data(unsigned char data) {
+    lcd_queue_op(data, LCD_OP_DATA, 50);
+}
+
+void lcd_create_char(unsigned char location, const unsigned char *pattern) {
+    int i;
+
+    lcd_command(0x40 | (location << 3));
+    for (i = 0; i < 8; i++) lcd_data(pattern[i]);
+    lcd_command(LCD_LINE1);
+}
+
+void lcd_init(void) {
+    hal_gpio_dir_out(LCD_DATA_MASK | LCD_RS | LCD_EN);
+    hal_timer1_init(lcd_timer_tick);
+
+    lcd_queue_op(0, LCD_OP_WAIT, 20000);       // Wait >15ms after power on
+    lcd_queue_op(0x03, LCD_OP_NIBBLE, 5000);
+    lcd_queue_op(0x03, LCD_OP_NIBBLE, 100);
+    lcd_queue_op(0x03, LCD_OP_NIBBLE, 100);
+    lcd_queue_op(0x02, LCD_OP_NIBBLE, 100);
+    lcd_command(0x28);          // 4-bit, 2 line, 5x7 font
+    lcd_command(0x0C);          // Display ON, cursor off
+    lcd_command(0x06);          // Entry mode: increment cursor, no shift
+    lcd_command(0x01);          // Clear display
+}
+
+void lcd_string(const char *str) {
+    while (*str) {
+        lcd_data(*str++);
+    }
+}
+
+int lcd_idle(void) {
+    return !lcd_running;
+}
@@ -0,0 +1,34 @@
+/*
+ * ==========================================================================
+ * lcd.h - HD44780 16x2 LCD driver (4-bit mode, ALS board wiring)
+ * ==========================================================================
+ * All calls queue and return at once; TIM1 clocks the bytes out.
+ * ==========================================================================
+ */
+
+#ifndef LCD_H
+#define LCD_H
+
+// --- Pin Definitions (ALS Board) ---
+#define LCD_DATA_MASK   (0xF << 23)     // P0.23-P0.26
+#define LCD_RS          (1 << 27)       // P0.27
+#define LCD_EN          (1 << 28)       // P0.28
+
+#define LCD_LINE1       0x80
+#define LCD_LINE2       0xC0
+
+#include <stdint.h>
+
+void lcd_init(void);
+void lcd_command(unsigned char cmd);
+void lcd_data(unsigned char data);
+void lcd_string(const char *str);
+void lcd_create_char(unsigned char location, const unsigned char *pattern);
+
+// 1 once everything queued has been sent and has settled
+int lcd_idle(void);
+
+// Times a caller had to wait for room in the queue
+extern uint32_t lcd_queue_waits;
+
+#endif // LCD_H
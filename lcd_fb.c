@@ -0,0 +1,56 @@
+/*
+ * ==========================================================================
+ * lcd_fb.c - Shadow framebuffer for the 16x2 LCD
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "lcd.h"
+#include "lcd_fb.h"
+
+#define LCD_FB_NO_CURSOR  0xFF
+
+static char fb_cells[LCD_FB_ROWS][LCD_FB_COLS];     // Wanted
+static char fb_shown[LCD_FB_ROWS][LCD_FB_COLS];     // On the LCD
+static uint8_t fb_shown_valid = 0;
+static uint8_t fb_cursor = LCD_FB_NO_CURSOR;        // DDRAM address
+
+uint32_t lcd_fb_bytes_last = 0;
+uint32_t lcd_fb_bytes_total = 0;
+
+void lcd_fb_init(void) {
+    memset(fb_cells, ' ', sizeof(fb_cells));
+    fb_shown_valid = 0;
+    fb_cursor = LCD_FB_NO_CURSOR;
+}
+
+void lcd_fb_puts(int row, int col, const char *str) {
+    while (*str && col < LCD_FB_COLS) {
+        fb_cells[row][col++] = *str++;
+    }
+}
+
+int lcd_fb_flush(void) {
+    int row, col, sent = 0;
+    uint8_t addr;
+
+    for (row = 0; row < LCD_FB_ROWS; row++) {
+        for (col = 0; col < LCD_FB_COLS; col++) {
+            if (fb_shown_valid && fb_cells[row][col] == fb_shown[row][col]) continue;
+
+            addr = (row ? 0x40 : 0x00) + col;
+            if (fb_cursor != addr) {
+                lcd_command(0x80 | addr);
+                sent++;
+            }
+            lcd_data(fb_cells[row][col]);
+            fb_shown[row][col] = fb_cells[row][col];
+            fb_cursor = addr + 1;
+            sent++;
+        }
+    }
+    fb_shown_valid = 1;
+    lcd_fb_bytes_last = sent;
+    lcd_fb_bytes_total += sent;
+    return sent;
+}
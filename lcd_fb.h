@@ -0,0 +1,33 @@
+/*
+ * ==========================================================================
+ * lcd_fb.h - Shadow framebuffer for the 16x2 LCD
+ * ==========================================================================
+ * Screens are drawn into RAM with lcd_fb_puts(); lcd_fb_flush() then
+ * sends only the cells that differ from what the LCD already shows,
+ * with a set-address command only where the cursor is not already in
+ * place. A reading that changes one digit costs 2 bytes instead of 34.
+ * ==========================================================================
+ */
+
+#ifndef LCD_FB_H
+#define LCD_FB_H
+
+#include <stdint.h>
+
+#define LCD_FB_ROWS  2
+#define LCD_FB_COLS  16
+
+// Forget what the LCD shows (after lcd_init): the next flush redraws all
+void lcd_fb_init(void);
+
+// Write text at (row, col), clipped at the end of the row
+void lcd_fb_puts(int row, int col, const char *str);
+
+// Send the changed cells; returns the bytes sent (commands + data)
+int lcd_fb_flush(void);
+
+// Statistics
+extern uint32_t lcd_fb_bytes_last;   // Bytes sent by the last flush
+extern uint32_t lcd_fb_bytes_total;
+
+#endif // LCD_FB_H
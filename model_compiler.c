@@ -0,0 +1,396 @@
+/*
+ * ==========================================================================
+ * model_compiler.c - Optimise the sensor forest node table (host tool)
+ * ==========================================================================
+ * Reads the forest from sensor_model_nodes.h and writes a smaller but
+ * equivalent sensor_model_nodes.h:
+ *
+ *   1. Interval propagation: the range each feature can still take is
+ *      carried down every path. A test that is always true or always
+ *      false on that range is replaced by the one child it can reach.
+ *   2. Subtree merging: a node whose two children are identical (same
+ *      leaf, or structurally equal subtrees) is replaced by that child.
+ *   3. Re-emission: nodes are renumbered in preorder (children after
+ *      their parent, as sensor_model_batch.c expects) and unreferenced
+ *      leaves are dropped from the leaf tables.
+ *
+ * The result is compared with the input forest on every cell of the
+ * feature threshold grid, in both float and fixed point. Nothing is
+ * written if any cell differs.
+ *
+ * Build and run on the host:
+ *     cc -O2 -o model_compiler model_compiler.c
+ *     ./model_compiler > sensor_model_nodes.new && mv sensor_model_nodes.new sensor_model_nodes.h
+ * ==========================================================================
+ */
+
+// Both leaf tables are needed to re-emit them
+#define AQ_FIXED_POINT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_model_nodes.h"
+
+#define MAX_NODES   SENSOR_MODEL_N_NODES
+
+// Working copy of the forest. Children use the same encoding as
+// sensor_model_nodes[]: node index, or ~leaf when negative.
+struct work_node {
+    int feature;
+    int threshold;
+    int left, right;
+};
+
+static struct work_node nodes[MAX_NODES];
+static int roots[SENSOR_MODEL_N_TREES];
+
+// Output forest
+static struct work_node out_nodes[MAX_NODES];
+static int out_roots[SENSOR_MODEL_N_TREES];
+static int n_out_nodes;
+static int leaf_map[SENSOR_MODEL_N_LEAVES];   // old leaf -> new leaf, -1 if unused
+static int n_out_leaves;
+
+static int pruned_tests, merged_subtrees;
+
+// --- Pass 1: interval propagation ---
+// lo[f] <= features[f] < hi[f] on the current path
+static int prune(int child, int *lo, int *hi) {
+    struct work_node *n;
+    int f, saved;
+
+    if (child < 0) return child;
+    n = &nodes[child];
+    f = n->feature;
+
+    if (n->threshold <= lo[f]) {          // never true
+        pruned_tests++;
+        return prune(n->right, lo, hi);
+    }
+    if (n->threshold >= hi[f]) {          // always true
+        pruned_tests++;
+        return prune(n->left, lo, hi);
+    }
+
+    saved = hi[f];
+    hi[f] = n->threshold;
+    n->left = prune(n->left, lo, hi);
+    hi[f] = saved;
+
+    saved = lo[f];
+    lo[f] = n->threshold;
+    n->right = prune(n->right, lo, hi);
+    lo[f] = saved;
+
+    return child;
+}
+
+// --- Pass 2: merge identical subtrees ---
+static int same_subtree(int a, int b) {
+    if (a < 0 || b < 0) return a == b;
+    return nodes[a].feature == nodes[b].feature &&
+           nodes[a].threshold == nodes[b].threshold &&
+           same_subtree(nodes[a].left, nodes[b].left) &&
+           same_subtree(nodes[a].right, nodes[b].right);
+}
+
+static int merge(int child) {
+    struct work_node *n;
+
+    if (child < 0) return child;
+    n = &nodes[child];
+    n->left = merge(n->left);
+    n->right = merge(n->right);
+    if (same_subtree(n->left, n->right)) {
+        merged_subtrees++;
+        return n->left;
+    }
+    return child;
+}
+
+// --- Pass 3: preorder renumbering ---
+static int emit(int child) {
+    int idx;
+
+    if (child < 0) {
+        int leaf = ~child;
+        if (leaf_map[leaf] < 0) leaf_map[leaf] = n_out_leaves++;
+        return ~leaf_map[leaf];
+    }
+    idx = n_out_nodes++;
+    out_nodes[idx].feature = nodes[child].feature;
+    out_nodes[idx].threshold = nodes[child].threshold;
+    out_nodes[idx].left = emit(nodes[child].left);
+    out_nodes[idx].right = emit(nodes[child].right);
+    return idx;
+}
+
+// --- Verification ---
+static int out_leaf(int root, const int16_t *features) {
+    int idx = root;
+
+    while (idx >= 0) {
+        const struct work_node *n = &out_nodes[idx];
+        idx = (features[n->feature] < n->threshold) ? n->left : n->right;
+    }
+    return ~idx;
+}
+
+// Leaf values in the new numbering
+static float out_leaves[SENSOR_MODEL_N_LEAVES];
+static aq_score_t out_leaves_fx[SENSOR_MODEL_N_LEAVES];
+
+// Candidate values per feature: every threshold, the value just below
+// it, and both extremes. These cover every cell of the threshold grid.
+static int16_t probes[SENSOR_MODEL_N_FEATURES][2 * SENSOR_MODEL_N_NODES + 2];
+static int n_probes[SENSOR_MODEL_N_FEATURES];
+
+static void collect_probes(void) {
+    int i, f;
+
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        probes[f][n_probes[f]++] = INT16_MIN;
+        probes[f][n_probes[f]++] = INT16_MAX;
+    }
+    for (i = 0; i < SENSOR_MODEL_N_NODES; i++) {
+        f = sensor_model_nodes[i].feature;
+        probes[f][n_probes[f]++] = sensor_model_nodes[i].threshold;
+        probes[f][n_probes[f]++] = (int16_t)(sensor_model_nodes[i].threshold - 1);
+    }
+}
+
+static int verify(void) {
+    int16_t x[SENSOR_MODEL_N_FEATURES];
+    int a, b, c, t;
+
+    collect_probes();
+    for (a = 0; a < n_probes[0]; a++) {
+        for (b = 0; b < n_probes[1]; b++) {
+            for (c = 0; c < n_probes[2]; c++) {
+                float avg = 0;
+                aq_score_t sum = 0, fx;
+                float ref;
+
+                x[0] = probes[0][a];
+                x[1] = probes[1][b];
+                x[2] = probes[2][c];
+                for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+                    int leaf = out_leaf(out_roots[t], x);
+                    avg += out_leaves[leaf];
+                    sum += out_leaves_fx[leaf];
+                }
+                avg /= SENSOR_MODEL_N_TREES;
+                fx = (sum + SENSOR_MODEL_N_TREES / 2) / SENSOR_MODEL_N_TREES;
+                ref = sensor_model_nodes_predict(x, SENSOR_MODEL_N_FEATURES);
+                if (memcmp(&avg, &ref, sizeof(avg)) != 0 || fx != sensor_model_nodes_score(x)) {
+                    fprintf(stderr, "mismatch at (%d, %d, %d): %f vs %f\n", x[0], x[1], x[2], avg, ref);
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// --- Output ---
+// Compares on the longest root-to-leaf path
+static int out_depth(int child) {
+    int l, r;
+
+    if (child < 0) return 0;
+    l = out_depth(out_nodes[child].left);
+    r = out_depth(out_nodes[child].right);
+    return 1 + (l > r ? l : r);
+}
+
+// Shortest of the emlearn "%f" form and "%.9g" that reads back exactly
+static void print_float(float v) {
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%f", v);
+    if (strtof(buf, NULL) != v) snprintf(buf, sizeof(buf), "%.9g", v);
+    printf("%sf", buf);
+}
+
+static void print_header(void) {
+    int t, i, depth = 0;
+
+    printf("%s",
+        "/*\n"
+        " * ==========================================================================\n"
+        " * sensor_model_nodes.h - Flattened node-array form of the emlearn forest\n"
+        " * ==========================================================================\n"
+        " * !!! Generated by model_compiler.c - do not edit by hand !!!\n"
+        " *\n"
+        " * Same five trees as sensor_model.h, stored as data instead of nested if\n"
+        " * ladders, with unreachable tests and identical subtrees removed. Each\n"
+        " * internal node holds the feature it tests, the threshold, and its two\n"
+        " * children. A negative child is a leaf: ~child indexes\n"
+        " * sensor_model_nodes_leaves[] (deduplicated, as emlearn does for\n"
+        " * sensor_model_leaves[]).\n"
+        " *\n"
+        " * Every tree is evaluated by the same small loop, so a model update only\n"
+        " * changes the tables below, not the code.\n"
+        " *\n"
+        " * Footprint: 6 bytes per node + 4 bytes per leaf.\n"
+        " *\n"
+        " * With AQ_FIXED_POINT the leaves are also kept in fixed point and\n"
+        " * sensor_model_nodes_score() averages them in integers.\n"
+        " * ==========================================================================\n"
+        " */\n"
+        "\n"
+        "#ifndef SENSOR_MODEL_NODES_H\n"
+        "#define SENSOR_MODEL_NODES_H\n"
+        "\n"
+        "#include <stdint.h>\n"
+        "#include \"aq_fixed.h\"\n"
+        "\n");
+
+    printf("#define SENSOR_MODEL_N_FEATURES  %d\n", SENSOR_MODEL_N_FEATURES);
+    printf("#define SENSOR_MODEL_N_TREES     %d\n", SENSOR_MODEL_N_TREES);
+    printf("#define SENSOR_MODEL_N_NODES     %d\n", n_out_nodes);
+    printf("#define SENSOR_MODEL_N_LEAVES    %d\n", n_out_leaves);
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        if (out_depth(out_roots[t]) > depth) depth = out_depth(out_roots[t]);
+    }
+    printf("#define SENSOR_MODEL_MAX_DEPTH   %d       // Compares on the longest path\n", depth);
+    printf("#define SENSOR_MODEL_NODES_BYTES %d     // Flash: nodes, roots, float leaves\n\n",
+           n_out_nodes * (int)sizeof(struct sensor_model_node) + SENSOR_MODEL_N_TREES + n_out_leaves * 4);
+
+    printf("%s",
+        "struct sensor_model_node {\n"
+        "    int8_t  feature;     // Feature index tested by this node\n"
+        "    int16_t threshold;   // Go left when features[feature] < threshold\n"
+        "    int8_t  left;        // Child node index, or ~leaf index when negative\n"
+        "    int8_t  right;\n"
+        "};\n"
+        "\n"
+        "static const struct sensor_model_node sensor_model_nodes[SENSOR_MODEL_N_NODES] = {\n");
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        int end = (t + 1 < SENSOR_MODEL_N_TREES) ? out_roots[t + 1] : n_out_nodes;
+
+        printf("    // Tree %d\n", t);
+        for (i = out_roots[t]; i < end; i++) {
+            printf("    { %d, %3d, %4d, %4d }%s\n", out_nodes[i].feature, out_nodes[i].threshold,
+                   out_nodes[i].left, out_nodes[i].right, (i + 1 < n_out_nodes) ? "," : "");
+        }
+    }
+    printf("};\n\n");
+
+    printf("static const int8_t sensor_model_nodes_roots[SENSOR_MODEL_N_TREES] = {");
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) printf("%s %d", t ? "," : "", out_roots[t]);
+    printf(" };\n\n");
+
+    printf("static const float sensor_model_nodes_leaves[SENSOR_MODEL_N_LEAVES] = {");
+    for (i = 0; i < n_out_leaves; i++) {
+        printf("%s%s", i ? "," : "", (i % 6) ? " " : "\n    ");
+        print_float(out_leaves[i]);
+    }
+    printf("\n};\n\n");
+
+    printf("#ifdef AQ_FIXED_POINT\n");
+    printf("static const aq_score_t sensor_model_nodes_leaves_fx[SENSOR_MODEL_N_LEAVES] = {");
+    for (i = 0; i < n_out_leaves; i++) {
+        printf("%s%sAQ_SCORE(", i ? "," : "", (i % 5) ? " " : "\n    ");
+        printf("%f)", out_leaves[i]);
+    }
+    printf("\n};\n#endif\n\n");
+
+    printf("%s",
+        "// Walk one tree from its root and return the index of the leaf reached\n"
+        "static inline int sensor_model_nodes_leaf(int root, const int16_t *features) {\n"
+        "    int idx = root;\n"
+        "\n"
+        "    while (idx >= 0) {\n"
+        "        const struct sensor_model_node *n = &sensor_model_nodes[idx];\n"
+        "        idx = (features[n->feature] < n->threshold) ? n->left : n->right;\n"
+        "    }\n"
+        "    return ~idx;\n"
+        "}\n"
+        "\n"
+        "// Drop-in replacement for sensor_model_predict()\n"
+        "static inline float sensor_model_nodes_predict(const int16_t *features, int32_t features_length) {\n"
+        "    float avg = 0;\n"
+        "    int t;\n"
+        "\n"
+        "    (void)features_length;\n"
+        "    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {\n"
+        "        avg += sensor_model_nodes_leaves[sensor_model_nodes_leaf(sensor_model_nodes_roots[t], features)];\n"
+        "    }\n"
+        "    return avg / SENSOR_MODEL_N_TREES;\n"
+        "}\n"
+        "\n"
+        "// Forest average as an aq_score_t (float, or fixed point with AQ_FIXED_POINT)\n"
+        "static inline aq_score_t sensor_model_nodes_score(const int16_t *features) {\n"
+        "#ifdef AQ_FIXED_POINT\n"
+        "    aq_score_t sum = 0;\n"
+        "    int t;\n"
+        "\n"
+        "    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {\n"
+        "        sum += sensor_model_nodes_leaves_fx[sensor_model_nodes_leaf(sensor_model_nodes_roots[t], features)];\n"
+        "    }\n"
+        "    return (sum + SENSOR_MODEL_N_TREES / 2) / SENSOR_MODEL_N_TREES;\n"
+        "#else\n"
+        "    return sensor_model_nodes_predict(features, SENSOR_MODEL_N_FEATURES);\n"
+        "#endif\n"
+        "}\n"
+        "\n"
+        "#endif // SENSOR_MODEL_NODES_H\n");
+}
+
+int main(void) {
+    int lo[SENSOR_MODEL_N_FEATURES], hi[SENSOR_MODEL_N_FEATURES];
+    int i, t, f;
+
+    for (i = 0; i < SENSOR_MODEL_N_NODES; i++) {
+        nodes[i].feature = sensor_model_nodes[i].feature;
+        nodes[i].threshold = sensor_model_nodes[i].threshold;
+        nodes[i].left = sensor_model_nodes[i].left;
+        nodes[i].right = sensor_model_nodes[i].right;
+    }
+    for (i = 0; i < SENSOR_MODEL_N_LEAVES; i++) leaf_map[i] = -1;
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+            lo[f] = INT16_MIN;
+            hi[f] = INT16_MAX + 1;
+        }
+        roots[t] = merge(prune(sensor_model_nodes_roots[t], lo, hi));
+        if (roots[t] < 0) {
+            fprintf(stderr, "tree %d collapsed to a single leaf\n", t);
+            return 1;
+        }
+        out_roots[t] = emit(roots[t]);
+    }
+
+    for (i = 0; i < SENSOR_MODEL_N_LEAVES; i++) {
+        if (leaf_map[i] < 0) continue;
+        out_leaves[leaf_map[i]] = sensor_model_nodes_leaves[i];
+        out_leaves_fx[leaf_map[i]] = sensor_model_nodes_leaves_fx[i];
+    }
+
+    // The fixed-point table is re-emitted as AQ_SCORE(%f); make sure that
+    // reproduces the current integers
+    for (i = 0; i < n_out_leaves; i++) {
+        char buf[32];
+
+        snprintf(buf, sizeof(buf), "%f", out_leaves[i]);
+        if (AQ_SCORE(strtod(buf, NULL)) != out_leaves_fx[i]) {
+            fprintf(stderr, "leaf %d: fixed-point value would change\n", i);
+            return 1;
+        }
+    }
+
+    if (!verify()) return 1;
+
+    fprintf(stderr, "nodes %d -> %d, leaves %d -> %d (%d tests pruned, %d subtrees merged)\n",
+            SENSOR_MODEL_N_NODES, n_out_nodes, SENSOR_MODEL_N_LEAVES, n_out_leaves,
+            pruned_tests, merged_subtrees);
+    fprintf(stderr, "flash: %d -> %d bytes\n",
+            SENSOR_MODEL_N_NODES * (int)sizeof(struct sensor_model_node) + SENSOR_MODEL_N_LEAVES * 4,
+            n_out_nodes * (int)sizeof(struct sensor_model_node) + n_out_leaves * 4);
+
+    print_header();
+    return 0;
+}
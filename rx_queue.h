@@ -0,0 +1,72 @@
+/*
+ * ==========================================================================
+ * rx_queue.h - Lock-free ring of received frames (UART ISR -> main loop)
+ * ==========================================================================
+ * Single producer (UART1_IRQHandler), single consumer (main loop). The
+ * ISR fills the slot at tail and publishes it by bumping tail; the main
+ * loop reads the slot at head and releases it by bumping head. Each
+ * index is written by one side only, so no locking is needed.
+ *
+ * A frame is one parsed line. If the ring is full when a line completes,
+ * the line is dropped and counted in overruns. Frames already queued are
+ * never overwritten.
+ *
+ * RX_QUEUE_DEPTH (a power of two) can be set on the compiler command line.
+ * ==========================================================================
+ */
+
+#ifndef RX_QUEUE_H
+#define RX_QUEUE_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "aq_parse.h"
+#include "aq_lat.h"
+
+#ifndef RX_QUEUE_DEPTH
+#define RX_QUEUE_DEPTH  8
+#endif
+
+typedef char rx_queue_depth_must_be_power_of_two[(RX_QUEUE_DEPTH & (RX_QUEUE_DEPTH - 1)) ? -1 : 1];
+
+struct rx_frame {
+    struct aq_reading reading;
+    uint8_t valid;                  // 0 if the line failed to parse
+#if AQ_LAT
+    struct aq_lat_stamp stamp;      // Arrival times
+#endif
+};
+
+struct rx_queue {
+    struct rx_frame frames[RX_QUEUE_DEPTH];
+    volatile uint32_t head;         // Written by the consumer only
+    volatile uint32_t tail;         // Written by the producer only
+    volatile uint32_t overruns;     // Lines dropped because the ring was full
+};
+
+// --- Producer side (ISR) ---
+// Slot to fill for the next frame, or 0 when the ring is full
+static inline struct rx_frame *rx_queue_slot(struct rx_queue *q) {
+    if (q->tail - q->head >= RX_QUEUE_DEPTH) return 0;
+    return &q->frames[q->tail % RX_QUEUE_DEPTH];
+}
+
+static inline void rx_queue_publish(struct rx_queue *q) {
+    HAL_BARRIER();                  // Frame contents before the new tail
+    q->tail = q->tail + 1;
+}
+
+// --- Consumer side (main loop) ---
+// Oldest queued frame, or 0 when the ring is empty
+static inline const struct rx_frame *rx_queue_peek(struct rx_queue *q) {
+    if (q->head == q->tail) return 0;
+    HAL_BARRIER();                  // Tail before the frame contents
+    return &q->frames[q->head % RX_QUEUE_DEPTH];
+}
+
+static inline void rx_queue_pop(struct rx_queue *q) {
+    HAL_BARRIER();                  // Done reading before the slot is reused
+    q->head = q->head + 1;
+}
+
+#endif // RX_QUEUE_H
@@ -0,0 +1,89 @@
+/*
+ * ==========================================================================
+ * sched.c - Cooperative task scheduler on the 1 ms system tick
+ * ==========================================================================
+ */
+
+#include "hal.h"
+#include "sched.h"
+
+static struct sched_task tasks[SCHED_MAX_TASKS];
+static int n_tasks = 0;
+
+uint32_t sched_runs = 0;
+uint32_t sched_wakeups = 0;
+
+// Wrap-safe "now is at or past due"
+#define SCHED_DUE(now, due)  ((int32_t)((now) - (due)) >= 0)
+
+int sched_add(void (*fn)(void)) {
+    if (n_tasks >= SCHED_MAX_TASKS) return -1;
+    tasks[n_tasks].fn = fn;
+    return n_tasks++;
+}
+
+void sched_every(int id, uint32_t period_ms) {
+    tasks[id].period = period_ms;
+    tasks[id].due = hal_millis() + period_ms;
+    tasks[id].armed = 1;
+}
+
+void sched_after(int id, uint32_t delay_ms) {
+    tasks[id].period = 0;
+    tasks[id].due = hal_millis() + delay_ms;
+    tasks[id].armed = 1;
+}
+
+void sched_signal(int id) {
+    tasks[id].signalled = 1;
+}
+
+void sched_cancel(int id) {
+    tasks[id].armed = 0;
+    tasks[id].signalled = 0;
+}
+
+static int sched_ready(uint32_t now) {
+    int i;
+
+    for (i = 0; i < n_tasks; i++) {
+        if (tasks[i].signalled || (tasks[i].armed && SCHED_DUE(now, tasks[i].due))) return 1;
+    }
+    return 0;
+}
+
+void sched_run(void) {
+    struct sched_task *t;
+    uint32_t now;
+    int i;
+
+    while (1) {
+        now = hal_millis();
+        for (i = 0; i < n_tasks; i++) {
+            t = &tasks[i];
+            if (t->signalled) {
+                t->signalled = 0;
+            } else if (t->armed && SCHED_DUE(now, t->due)) {
+                if (t->period == 0) {
+                    t->armed = 0;
+                } else {
+                    t->due += t->period;
+                    if (SCHED_DUE(now, t->due)) t->due = now + t->period;  // Fell behind
+                }
+            } else {
+                continue;
+            }
+            sched_runs++;
+            t->fn();
+        }
+
+        // Interrupts stay pending while masked, so a frame that arrives
+        // between the check and WFI still wakes the core
+        hal_irq_disable();
+        if (!sched_ready(hal_millis())) {
+            hal_idle();
+            sched_wakeups++;
+        }
+        hal_irq_enable();
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * ==========================================================================
+ * sched.h - Cooperative task scheduler on the 1 ms system tick
+ * ==========================================================================
+ * Tasks are plain functions that run to completion in the main loop.
+ * A task runs when:
+ *   - its timer expires (sched_every: periodic, sched_after: one-shot), or
+ *   - it is signalled (sched_signal, safe to call from an ISR).
+ *
+ * When nothing is due the core sleeps in WFI. Any interrupt wakes it:
+ * the tick, or UART1 as soon as a frame arrives, so a signalled task
+ * starts within microseconds instead of at the next polling pass.
+ * ==========================================================================
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS  8
+
+struct sched_task {
+    void (*fn)(void);
+    uint32_t due;                   // hal_millis() of the next timed run
+    uint32_t period;                // 0 for a one-shot
+    uint8_t armed;                  // Timed run pending
+    volatile uint8_t signalled;     // Run as soon as possible
+};
+
+// Register a task (not scheduled yet); returns its id, or -1 if full
+int sched_add(void (*fn)(void));
+
+void sched_every(int id, uint32_t period_ms);
+void sched_after(int id, uint32_t delay_ms);
+void sched_signal(int id);
+void sched_cancel(int id);
+
+// Run tasks forever, sleeping in between
+void sched_run(void);
+
+// Statistics
+extern uint32_t sched_runs;
+extern uint32_t sched_wakeups;
+
+#endif // SCHED_H
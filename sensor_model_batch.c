@@ -0,0 +1,168 @@
+/*
+ * ==========================================================================
+ * sensor_model_batch.c - SIMD compare-and-blend kernels for the forest
+ * ==========================================================================
+ * Every node of sensor_model_nodes[] is evaluated for a whole vector of
+ * samples at once. Children always sit after their parent in the node
+ * table, so walking it backwards lets each node blend the already-known
+ * results of its two subtrees with one compare and one blend:
+ *
+ *     leaf[node] = (x[feature] < threshold) ? leaf[left] : leaf[right]
+ *
+ * The leaf values reached are then summed tree by tree in the same order
+ * as sensor_model_predict() and divided by the tree count, which keeps
+ * the result bit-identical to the scalar model.
+ * ==========================================================================
+ */
+
+#include <assert.h>
+#include "sensor_model_batch.h"
+#include "sensor_model_qs.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// --- Scalar fallback (also used for the tail of a block) ---
+// Uses the branch-free QuickScorer evaluator, so cost does not depend on
+// the data even without SIMD. Its tables come from sensor_model_qs_init(),
+// which the caller runs once before any thread scores a batch.
+// AQ_FIXED_POINT builds have no float QuickScorer and walk the nodes
+static void predict_scalar(const int16_t *const features[SENSOR_MODEL_N_FEATURES],
+                           float *out, int32_t start, int32_t end) {
+    int16_t sample[SENSOR_MODEL_N_FEATURES];
+    int32_t i;
+    int f;
+
+    for (i = start; i < end; i++) {
+        for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) sample[f] = features[f][i];
+#ifdef AQ_FIXED_POINT
+        out[i] = sensor_model_nodes_predict(sample, SENSOR_MODEL_N_FEATURES);
+#else
+        out[i] = sensor_model_qs_predict(sample, SENSOR_MODEL_N_FEATURES);
+#endif
+    }
+}
+
+/*
+ * The SIMD kernels blend int16 leaf indices rather than float values, so
+ * one vector covers twice as many samples, and look the leaf values up
+ * once per tree at the end. Identical (feature, threshold) tests that
+ * appear in several trees collapse into a single compare once the node
+ * loop is unrolled.
+ */
+#if defined(__AVX2__)
+
+#define BATCH_LANES 16
+
+static int32_t predict_simd(const int16_t *const features[SENSOR_MODEL_N_FEATURES],
+                            float *out, int32_t n_samples) {
+    __m256i x[SENSOR_MODEL_N_FEATURES];
+    __m256i leaf[SENSOR_MODEL_N_NODES];
+    const __m256 n_trees = _mm256_set1_ps((float)SENSOR_MODEL_N_TREES);
+    int32_t i;
+    int f, node, t;
+
+    for (i = 0; i + BATCH_LANES <= n_samples; i += BATCH_LANES) {
+        __m256 avg_lo = _mm256_setzero_ps();
+        __m256 avg_hi = _mm256_setzero_ps();
+
+        for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+            x[f] = _mm256_loadu_si256((const __m256i *)(features[f] + i));
+        }
+
+#pragma GCC unroll 128
+        for (node = SENSOR_MODEL_N_NODES - 1; node >= 0; node--) {
+            const struct sensor_model_node *n = &sensor_model_nodes[node];
+            __m256i left = (n->left < 0) ? _mm256_set1_epi16(~n->left) : leaf[n->left];
+            __m256i right = (n->right < 0) ? _mm256_set1_epi16(~n->right) : leaf[n->right];
+            __m256i go_left = _mm256_cmpgt_epi16(_mm256_set1_epi16(n->threshold), x[n->feature]);
+
+            leaf[node] = _mm256_blendv_epi8(right, left, go_left);
+        }
+
+#pragma GCC unroll 16
+        for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+            __m256i idx = leaf[sensor_model_nodes_roots[t]];
+            __m256i idx_lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(idx));
+            __m256i idx_hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(idx, 1));
+
+            avg_lo = _mm256_add_ps(avg_lo, _mm256_i32gather_ps(sensor_model_nodes_leaves, idx_lo, 4));
+            avg_hi = _mm256_add_ps(avg_hi, _mm256_i32gather_ps(sensor_model_nodes_leaves, idx_hi, 4));
+        }
+        _mm256_storeu_ps(out + i, _mm256_div_ps(avg_lo, n_trees));
+        _mm256_storeu_ps(out + i + 8, _mm256_div_ps(avg_hi, n_trees));
+    }
+    return i;
+}
+
+#elif defined(__SSE4_1__)
+
+#define BATCH_LANES 8
+
+static int32_t predict_simd(const int16_t *const features[SENSOR_MODEL_N_FEATURES],
+                            float *out, int32_t n_samples) {
+    __m128i x[SENSOR_MODEL_N_FEATURES];
+    __m128i leaf[SENSOR_MODEL_N_NODES];
+    const __m128 n_trees = _mm_set1_ps((float)SENSOR_MODEL_N_TREES);
+    int16_t idx[BATCH_LANES];
+    const float *lv = sensor_model_nodes_leaves;
+    int32_t i;
+    int f, node, t;
+
+    for (i = 0; i + BATCH_LANES <= n_samples; i += BATCH_LANES) {
+        __m128 avg_lo = _mm_setzero_ps();
+        __m128 avg_hi = _mm_setzero_ps();
+
+        for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+            x[f] = _mm_loadu_si128((const __m128i *)(features[f] + i));
+        }
+
+#pragma GCC unroll 128
+        for (node = SENSOR_MODEL_N_NODES - 1; node >= 0; node--) {
+            const struct sensor_model_node *n = &sensor_model_nodes[node];
+            __m128i left = (n->left < 0) ? _mm_set1_epi16(~n->left) : leaf[n->left];
+            __m128i right = (n->right < 0) ? _mm_set1_epi16(~n->right) : leaf[n->right];
+            __m128i go_left = _mm_cmplt_epi16(x[n->feature], _mm_set1_epi16(n->threshold));
+
+            leaf[node] = _mm_blendv_epi8(right, left, go_left);
+        }
+
+        // No gather before AVX2: spill the indices and load the leaves
+#pragma GCC unroll 16
+        for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+            _mm_storeu_si128((__m128i *)idx, leaf[sensor_model_nodes_roots[t]]);
+            avg_lo = _mm_add_ps(avg_lo, _mm_setr_ps(lv[idx[0]], lv[idx[1]], lv[idx[2]], lv[idx[3]]));
+            avg_hi = _mm_add_ps(avg_hi, _mm_setr_ps(lv[idx[4]], lv[idx[5]], lv[idx[6]], lv[idx[7]]));
+        }
+        _mm_storeu_ps(out + i, _mm_div_ps(avg_lo, n_trees));
+        _mm_storeu_ps(out + i + 4, _mm_div_ps(avg_hi, n_trees));
+    }
+    return i;
+}
+
+#endif
+
+void sensor_model_predict_batch(const int16_t *const features[SENSOR_MODEL_N_FEATURES],
+                                float *out, int32_t n_samples) {
+    int32_t done = 0;
+
+#ifndef AQ_FIXED_POINT
+    // Without its tables the QuickScorer tail returns wrong scores
+    assert(sensor_model_qs_ready() && "call sensor_model_qs_init() before batch scoring");
+#endif
+#if defined(__AVX2__) || defined(__SSE4_1__)
+    done = predict_simd(features, out, n_samples);
+#endif
+    predict_scalar(features, out, done, n_samples);
+}
+
+const char *sensor_model_batch_kernel(void) {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE4_1__)
+    return "sse4.1";
+#else
+    return "scalar";
+#endif
+}
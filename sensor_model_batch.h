@@ -0,0 +1,32 @@
+/*
+ * ==========================================================================
+ * sensor_model_batch.h - Batch scoring of the sensor forest (host side)
+ * ==========================================================================
+ * Scores a block of samples given as a structure of arrays:
+ * features[f][i] is feature f of sample i. Results are bit-identical to
+ * sensor_model_predict() for every sample.
+ *
+ * The kernel is picked at compile time: AVX2 (-mavx2), SSE4.1 (-msse4.1),
+ * or the scalar QuickScorer evaluator (sensor_model_qs.c) when neither is
+ * enabled.
+ *
+ * Call sensor_model_qs_init() once before the first batch: the scalar
+ * kernel scores the tail of every block with its tables, and nothing here
+ * initialises them, so several threads may score batches at the same time.
+ * Debug builds assert that it has run.
+ * ==========================================================================
+ */
+
+#ifndef SENSOR_MODEL_BATCH_H
+#define SENSOR_MODEL_BATCH_H
+
+#include <stdint.h>
+#include "sensor_model_nodes.h"
+
+void sensor_model_predict_batch(const int16_t *const features[SENSOR_MODEL_N_FEATURES],
+                                float *out, int32_t n_samples);
+
+// Name of the kernel compiled in ("avx2", "sse4.1" or "scalar")
+const char *sensor_model_batch_kernel(void);
+
+#endif // SENSOR_MODEL_BATCH_H
@@ -0,0 +1,216 @@
+/*
+ * ==========================================================================
+ * sensor_model_lut.h - Partition lookup table for the sensor forest
+ * ==========================================================================
+ * !!! Generated by sensor_model_lut_gen.c from sensor_model_nodes.h !!!
+ *
+ * The forest is constant on each cell of the grid formed by the distinct
+ * thresholds of each feature. A prediction is one binary search per
+ * feature to find its bin, then one load from the cell table.
+ *
+ * 1472 cells, 137 distinct values, 2092 bytes of flash.
+ * Checked against sensor_model_predict() at every cell corner.
+ * ==========================================================================
+ */
+
+#ifndef SENSOR_MODEL_LUT_H
+#define SENSOR_MODEL_LUT_H
+
+#include <stdint.h>
+#include "aq_fixed.h"
+
+#define SENSOR_MODEL_LUT_BINS_0  23
+#define SENSOR_MODEL_LUT_BINS_1  8
+#define SENSOR_MODEL_LUT_BINS_2  8
+#define SENSOR_MODEL_LUT_VALUES  137
+#define SENSOR_MODEL_LUT_CELLS   1472
+#define SENSOR_MODEL_LUT_BYTES   2092    // Flash, float build
+
+static const int16_t sensor_model_lut_thresholds_0[SENSOR_MODEL_LUT_BINS_0 - 1] = {
+    18, 20, 21, 23, 25, 27, 28, 31, 33, 36, 37, 38, 40, 41, 44, 45,
+    49, 53, 54, 59, 60, 71
+};
+
+static const int16_t sensor_model_lut_thresholds_1[SENSOR_MODEL_LUT_BINS_1 - 1] = {
+    29, 30, 31, 32, 33, 34, 35
+};
+
+static const int16_t sensor_model_lut_thresholds_2[SENSOR_MODEL_LUT_BINS_2 - 1] = {
+    75, 77, 81, 83, 86, 87, 88
+};
+
+// Distinct forest outputs
+static const float sensor_model_lut_values[SENSOR_MODEL_LUT_VALUES] = {
+    64.6678619f, 73.0415039f, 87.8741074f, 67.8397903f, 76.2134399f, 91.0460358f,
+    76.9892578f, 85.611824f, 97.3264694f, 86.1725006f, 91.0299454f, 112.223328f,
+    88.332901f, 93.886795f, 98.7442322f, 119.937622f, 93.7285538f, 99.2824478f,
+    104.139877f, 125.333267f, 121.219604f, 129.204056f, 135.210724f, 134.902771f,
+    142.887222f, 148.89389f, 141.522751f, 149.507202f, 155.51387f, 131.463959f,
+    137.717178f, 145.70163f, 151.708282f, 139.593231f, 145.846451f, 153.830902f,
+    159.837555f, 146.213226f, 152.466431f, 160.450882f, 166.45755f, 153.725677f,
+    159.978882f, 165.98555f, 173.823334f, 161.85495f, 168.108154f, 174.114822f,
+    181.952606f, 177.014816f, 183.268021f, 191.493973f, 199.331757f, 189.66835f,
+    195.921555f, 204.147507f, 211.985306f, 195.380325f, 203.606277f, 211.444046f,
+    218.975876f, 227.201828f, 235.039597f, 201.773056f, 209.999023f, 213.124557f,
+    221.35054f, 236.720123f, 244.946091f, 242.48291f, 250.708832f, 199.688385f,
+    207.914337f, 224.486252f, 232.712204f, 248.081818f, 256.30777f, 269.342682f,
+    277.568634f, 223.033615f, 247.831497f, 258.773499f, 276.691376f, 316.035583f,
+    349.650024f, 229.396973f, 263.072327f, 280.990173f, 326.968903f, 360.583344f,
+    246.386307f, 271.983856f, 347.498901f, 381.113342f, 255.885788f, 281.483337f,
+    290.489655f, 277.710999f, 294.431091f, 303.437408f, 366.726593f, 400.341034f,
+    307.380859f, 320.368164f, 332.783295f, 339.558136f, 351.973297f, 392.984009f,
+    426.59845f, 305.105865f, 318.09317f, 330.508301f, 328.495026f, 341.48233f,
+    353.897522f, 360.672333f, 373.087463f, 411.932617f, 434.648438f, 307.168762f,
+    320.156067f, 332.571228f, 355.361969f, 368.349274f, 380.764404f, 378.532928f,
+    390.948059f, 439.467529f, 454.963806f, 323.780579f, 336.767883f, 349.183014f,
+    371.973724f, 384.961029f, 397.376221f, 395.144714f, 407.559875f
+};
+
+#ifdef AQ_FIXED_POINT
+static const aq_score_t sensor_model_lut_values_fx[SENSOR_MODEL_LUT_VALUES] = {
+    6467, 7304, 8787, 6784, 7622, 9105, 7699, 8561, 9733, 8617,
+    9103, 11222, 8834, 9389, 9875, 11994, 9373, 9928, 10414, 12533,
+    12122, 12920, 13521, 13490, 14289, 14889, 14152, 14951, 15551, 13146,
+    13772, 14570, 15171, 13959, 14585, 15383, 15984, 14621, 15247, 16045,
+    16646, 15372, 15998, 16598, 17382, 16185, 16811, 17411, 18195, 17701,
+    18327, 19149, 19933, 18967, 19592, 20415, 21198, 19538, 20360, 21144,
+    21897, 22720, 23504, 20177, 21000, 21312, 22135, 23672, 24495, 24248,
+    25071, 19969, 20791, 22449, 23271, 24808, 25631, 26934, 27757, 22303,
+    24783, 25877, 27669, 31603, 34965, 22940, 26307, 28099, 32697, 36058,
+    24639, 27199, 34750, 38111, 25589, 28149, 29049, 27771, 29443, 30344,
+    36673, 40034, 30738, 32037, 33279, 33956, 35198, 39298, 42660, 30511,
+    31809, 33051, 32850, 34148, 35390, 36067, 37309, 41193, 43465, 30717,
+    32016, 33257, 35536, 36835, 38077, 37853, 39095, 43947, 45497, 32378,
+    33677, 34918, 37198, 38496, 39738, 39515, 40756
+};
+#endif
+
+// Value index of each cell, indexed [bin0][bin1][bin2]
+static const uint8_t sensor_model_lut_cells[1472] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+    10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13,
+    14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17,
+    18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19,
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+    20, 20, 21, 22, 22, 22, 22, 22, 23, 23, 24, 25, 25, 25, 25, 25,
+    26, 26, 27, 28, 28, 28, 28, 28, 26, 26, 27, 28, 28, 28, 28, 28,
+    26, 26, 27, 28, 28, 28, 28, 28, 26, 26, 27, 28, 28, 28, 28, 28,
+    26, 26, 27, 28, 28, 28, 28, 28, 26, 26, 27, 28, 28, 28, 28, 28,
+    29, 30, 31, 32, 32, 32, 32, 32, 33, 34, 35, 36, 36, 36, 36, 36,
+    37, 38, 39, 40, 40, 40, 40, 40, 37, 38, 39, 40, 40, 40, 40, 40,
+    37, 38, 39, 40, 40, 40, 40, 40, 37, 38, 39, 40, 40, 40, 40, 40,
+    37, 38, 39, 40, 40, 40, 40, 40, 37, 38, 39, 40, 40, 40, 40, 40,
+    41, 42, 42, 43, 43, 43, 43, 44, 45, 46, 46, 47, 47, 47, 47, 48,
+    45, 46, 46, 47, 47, 47, 47, 48, 45, 46, 46, 47, 47, 47, 47, 48,
+    45, 46, 46, 47, 47, 47, 47, 48, 45, 46, 46, 47, 47, 47, 47, 48,
+    45, 46, 46, 47, 47, 47, 47, 48, 45, 46, 46, 47, 47, 47, 47, 48,
+    49, 50, 50, 50, 50, 51, 51, 52, 49, 50, 50, 50, 50, 51, 51, 52,
+    49, 50, 50, 50, 50, 51, 51, 52, 49, 50, 50, 50, 50, 51, 51, 52,
+    53, 54, 54, 54, 54, 55, 55, 56, 53, 54, 54, 54, 54, 55, 55, 56,
+    53, 54, 54, 54, 54, 55, 55, 56, 53, 54, 54, 54, 54, 55, 55, 56,
+    57, 57, 57, 57, 57, 58, 58, 59, 57, 57, 57, 57, 57, 58, 58, 59,
+    57, 57, 57, 57, 57, 58, 58, 59, 57, 57, 57, 57, 57, 58, 58, 59,
+    60, 60, 60, 60, 60, 61, 61, 62, 60, 60, 60, 60, 60, 61, 61, 62,
+    60, 60, 60, 60, 60, 61, 61, 62, 60, 60, 60, 60, 60, 61, 61, 62,
+    63, 63, 63, 63, 63, 64, 64, 64, 63, 63, 63, 63, 63, 64, 64, 64,
+    63, 63, 63, 63, 63, 64, 64, 64, 65, 65, 65, 65, 65, 66, 66, 66,
+    67, 67, 67, 67, 67, 68, 68, 68, 67, 67, 67, 67, 67, 68, 68, 68,
+    69, 69, 69, 69, 69, 70, 70, 70, 69, 69, 69, 69, 69, 70, 70, 70,
+    71, 71, 71, 71, 71, 72, 72, 72, 71, 71, 71, 71, 71, 72, 72, 72,
+    71, 71, 71, 71, 71, 72, 72, 72, 73, 73, 73, 73, 73, 74, 74, 74,
+    75, 75, 75, 75, 75, 76, 76, 76, 75, 75, 75, 75, 75, 76, 76, 76,
+    77, 77, 77, 77, 77, 78, 78, 78, 77, 77, 77, 77, 77, 78, 78, 78,
+    79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79,
+    79, 79, 79, 79, 79, 79, 79, 79, 80, 80, 80, 80, 80, 80, 80, 80,
+    81, 81, 81, 81, 81, 81, 81, 81, 82, 82, 82, 82, 82, 82, 82, 82,
+    83, 83, 83, 83, 83, 83, 83, 83, 84, 84, 84, 84, 84, 84, 84, 84,
+    85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85, 85,
+    85, 85, 85, 85, 85, 85, 85, 85, 86, 86, 86, 86, 86, 86, 86, 86,
+    86, 86, 86, 86, 86, 86, 86, 86, 87, 87, 87, 87, 87, 87, 87, 87,
+    88, 88, 88, 88, 88, 88, 88, 88, 89, 89, 89, 89, 89, 89, 89, 89,
+    90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90,
+    90, 90, 90, 90, 90, 90, 90, 90, 91, 91, 91, 91, 91, 91, 91, 91,
+    91, 91, 91, 91, 91, 91, 91, 91, 87, 87, 87, 87, 87, 87, 87, 87,
+    88, 88, 88, 88, 88, 88, 88, 88, 89, 89, 89, 89, 89, 89, 89, 89,
+    90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90,
+    90, 90, 90, 90, 90, 90, 90, 90, 91, 91, 91, 91, 91, 91, 91, 91,
+    91, 91, 91, 91, 91, 91, 91, 91, 87, 87, 87, 87, 87, 87, 87, 87,
+    92, 92, 92, 92, 92, 92, 92, 92, 93, 93, 93, 93, 93, 93, 93, 93,
+    94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94, 94,
+    94, 94, 94, 94, 94, 94, 94, 94, 95, 95, 95, 95, 95, 95, 95, 95,
+    95, 95, 95, 95, 95, 95, 95, 95, 96, 96, 96, 96, 96, 96, 96, 96,
+    92, 92, 92, 92, 92, 92, 92, 92, 93, 93, 93, 93, 93, 93, 93, 93,
+    97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97, 97,
+    97, 97, 97, 97, 97, 97, 97, 97, 98, 98, 98, 98, 98, 98, 98, 98,
+    98, 98, 98, 98, 98, 98, 98, 98, 99, 99, 99, 99, 99, 99, 99, 99,
+    100, 100, 100, 100, 100, 100, 100, 100, 101, 101, 101, 101, 101, 101, 101, 101,
+    102, 102, 102, 102, 103, 103, 104, 104, 102, 102, 102, 102, 103, 103, 104, 104,
+    102, 102, 102, 102, 103, 103, 104, 104, 102, 102, 102, 102, 103, 103, 104, 104,
+    102, 102, 102, 102, 103, 103, 104, 104, 105, 105, 105, 105, 105, 105, 106, 106,
+    107, 107, 107, 107, 107, 107, 107, 107, 108, 108, 108, 108, 108, 108, 108, 108,
+    109, 109, 109, 109, 110, 110, 111, 111, 109, 109, 109, 109, 110, 110, 111, 111,
+    109, 109, 109, 109, 110, 110, 111, 111, 109, 109, 109, 109, 110, 110, 111, 111,
+    112, 112, 112, 112, 113, 113, 114, 114, 115, 115, 115, 115, 115, 115, 116, 116,
+    117, 117, 117, 117, 117, 117, 117, 117, 118, 118, 118, 118, 118, 118, 118, 118,
+    119, 119, 119, 119, 120, 120, 121, 121, 119, 119, 119, 119, 120, 120, 121, 121,
+    119, 119, 119, 119, 120, 120, 121, 121, 119, 119, 119, 119, 120, 120, 121, 121,
+    122, 122, 122, 122, 123, 123, 124, 124, 125, 125, 125, 125, 125, 125, 126, 126,
+    127, 127, 127, 127, 127, 127, 127, 127, 128, 128, 128, 128, 128, 128, 128, 128,
+    129, 129, 129, 129, 130, 130, 131, 131, 129, 129, 129, 129, 130, 130, 131, 131,
+    129, 129, 129, 129, 130, 130, 131, 131, 129, 129, 129, 129, 130, 130, 131, 131,
+    132, 132, 132, 132, 133, 133, 134, 134, 135, 135, 135, 135, 135, 135, 136, 136,
+    127, 127, 127, 127, 127, 127, 127, 127, 128, 128, 128, 128, 128, 128, 128, 128
+};
+
+// Number of thresholds <= x, i.e. the bin x falls in
+static inline int sensor_model_lut_bin(const int16_t *thr, int n, int16_t x) {
+    const int16_t *base = thr;
+
+    while (n > 1) {
+        int half = n / 2;
+        base = (base[half] <= x) ? base + half : base;
+        n -= half;
+    }
+    return (int)(base - thr) + (*base <= x);
+}
+
+static inline int sensor_model_lut_cell(const int16_t *features) {
+    int b0 = sensor_model_lut_bin(sensor_model_lut_thresholds_0, SENSOR_MODEL_LUT_BINS_0 - 1, features[0]);
+    int b1 = sensor_model_lut_bin(sensor_model_lut_thresholds_1, SENSOR_MODEL_LUT_BINS_1 - 1, features[1]);
+    int b2 = sensor_model_lut_bin(sensor_model_lut_thresholds_2, SENSOR_MODEL_LUT_BINS_2 - 1, features[2]);
+
+    return (b0 * SENSOR_MODEL_LUT_BINS_1 + b1) * SENSOR_MODEL_LUT_BINS_2 + b2;
+}
+
+// Same contract as sensor_model_predict()
+static inline float sensor_model_lut_predict(const int16_t *features, int32_t features_length) {
+    (void)features_length;
+    return sensor_model_lut_values[sensor_model_lut_cells[sensor_model_lut_cell(features)]];
+}
+
+#ifdef AQ_FIXED_POINT
+static inline aq_score_t sensor_model_lut_score(const int16_t *features) {
+    return sensor_model_lut_values_fx[sensor_model_lut_cells[sensor_model_lut_cell(features)]];
+}
+#endif
+
+#endif // SENSOR_MODEL_LUT_H
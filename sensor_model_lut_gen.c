@@ -0,0 +1,226 @@
+/*
+ * ==========================================================================
+ * sensor_model_lut_gen.c - Generate the partition lookup table (host tool)
+ * ==========================================================================
+ * The forest is piecewise constant on the grid formed by the distinct
+ * thresholds of each feature. This tool enumerates every cell of that
+ * grid, stores the averaged prediction of each cell, and writes
+ * sensor_model_lut.h.
+ *
+ * Every cell is checked at all of its corners (the first and last value
+ * of each feature bin) against sensor_model_predict() from
+ * sensor_model.h, and against the fixed-point forest score. Any mismatch
+ * aborts generation.
+ *
+ * Build and run on the host:
+ *     cc -O2 -o sensor_model_lut_gen sensor_model_lut_gen.c
+ *     ./sensor_model_lut_gen > sensor_model_lut.h
+ * ==========================================================================
+ */
+
+// Both score types are needed: float for sensor_model_predict(), fixed
+// point for the AQ_FIXED_POINT firmware build
+#define AQ_FIXED_POINT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_model.h"
+#include "sensor_model_nodes.h"
+
+#define MAX_BINS    (SENSOR_MODEL_N_NODES + 1)
+#define MAX_CELLS   (MAX_BINS * MAX_BINS * MAX_BINS)
+
+static int16_t thresholds[SENSOR_MODEL_N_FEATURES][SENSOR_MODEL_N_NODES];
+static int n_thresholds[SENSOR_MODEL_N_FEATURES];
+
+static uint16_t cells[MAX_CELLS];
+static float values[MAX_CELLS];
+static aq_score_t values_fx[MAX_CELLS];
+static int n_values;
+
+static void collect_thresholds(void) {
+    int i, j, f;
+
+    for (i = 0; i < SENSOR_MODEL_N_NODES; i++) {
+        int16_t thr = sensor_model_nodes[i].threshold;
+        int16_t *list;
+        int *n;
+
+        f = sensor_model_nodes[i].feature;
+        list = thresholds[f];
+        n = &n_thresholds[f];
+        for (j = 0; j < *n && list[j] < thr; j++);
+        if (j < *n && list[j] == thr) continue;
+        memmove(&list[j + 1], &list[j], (*n - j) * sizeof(list[0]));
+        list[j] = thr;
+        (*n)++;
+    }
+}
+
+// First and last feature value that falls in bin b
+static int16_t bin_low(int f, int b) {
+    return (b == 0) ? INT16_MIN : thresholds[f][b - 1];
+}
+
+static int16_t bin_high(int f, int b) {
+    return (b == n_thresholds[f]) ? INT16_MAX : (int16_t)(thresholds[f][b] - 1);
+}
+
+static int value_index(float v, aq_score_t fx) {
+    int i;
+
+    for (i = 0; i < n_values; i++) {
+        if (memcmp(&values[i], &v, sizeof(v)) == 0 && values_fx[i] == fx) return i;
+    }
+    values[n_values] = v;
+    values_fx[n_values] = fx;
+    return n_values++;
+}
+
+// Check every corner of a cell against the reference models
+static int check_cell(const int *bins, float v, aq_score_t fx) {
+    int16_t features[SENSOR_MODEL_N_FEATURES];
+    int corner, f;
+
+    for (corner = 0; corner < (1 << SENSOR_MODEL_N_FEATURES); corner++) {
+        float ref;
+
+        for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+            features[f] = (corner & (1 << f)) ? bin_high(f, bins[f]) : bin_low(f, bins[f]);
+        }
+        ref = sensor_model_predict(features, SENSOR_MODEL_N_FEATURES);
+        if (memcmp(&ref, &v, sizeof(v)) != 0 || sensor_model_nodes_score(features) != fx) {
+            fprintf(stderr, "mismatch at (%d, %d, %d): lut %f, model %f\n",
+                    features[0], features[1], features[2], v, ref);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    int bins[SENSOR_MODEL_N_FEATURES];
+    int n_bins[SENSOR_MODEL_N_FEATURES];
+    int16_t features[SENSOR_MODEL_N_FEATURES];
+    int n_cells = 1, cell, f, i;
+    int cell_bytes, table_bytes;
+
+    collect_thresholds();
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        n_bins[f] = n_thresholds[f] + 1;
+        n_cells *= n_bins[f];
+    }
+
+    for (cell = 0; cell < n_cells; cell++) {
+        float v;
+        aq_score_t fx;
+        int rest = cell;
+
+        for (f = SENSOR_MODEL_N_FEATURES - 1; f >= 0; f--) {
+            bins[f] = rest % n_bins[f];
+            rest /= n_bins[f];
+            features[f] = bin_low(f, bins[f]);
+        }
+        v = sensor_model_nodes_predict(features, SENSOR_MODEL_N_FEATURES);
+        fx = sensor_model_nodes_score(features);
+        if (!check_cell(bins, v, fx)) return 1;
+        cells[cell] = (uint16_t)value_index(v, fx);
+    }
+
+    cell_bytes = (n_values <= 256) ? 1 : 2;
+    table_bytes = n_cells * cell_bytes + n_values * (int)sizeof(float);
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) table_bytes += n_thresholds[f] * (int)sizeof(int16_t);
+    fprintf(stderr, "%d cells, %d distinct values, %d bytes of flash (float build)\n",
+            n_cells, n_values, table_bytes);
+
+    printf("/*\n");
+    printf(" * ==========================================================================\n");
+    printf(" * sensor_model_lut.h - Partition lookup table for the sensor forest\n");
+    printf(" * ==========================================================================\n");
+    printf(" * !!! Generated by sensor_model_lut_gen.c from sensor_model_nodes.h !!!\n");
+    printf(" *\n");
+    printf(" * The forest is constant on each cell of the grid formed by the distinct\n");
+    printf(" * thresholds of each feature. A prediction is one binary search per\n");
+    printf(" * feature to find its bin, then one load from the cell table.\n");
+    printf(" *\n");
+    printf(" * %d cells, %d distinct values, %d bytes of flash.\n", n_cells, n_values, table_bytes);
+    printf(" * Checked against sensor_model_predict() at every cell corner.\n");
+    printf(" * ==========================================================================\n");
+    printf(" */\n\n");
+    printf("#ifndef SENSOR_MODEL_LUT_H\n#define SENSOR_MODEL_LUT_H\n\n");
+    printf("#include <stdint.h>\n#include \"aq_fixed.h\"\n\n");
+
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        printf("#define SENSOR_MODEL_LUT_BINS_%d  %d\n", f, n_bins[f]);
+    }
+    printf("#define SENSOR_MODEL_LUT_VALUES  %d\n", n_values);
+    printf("#define SENSOR_MODEL_LUT_CELLS   %d\n", n_cells);
+    printf("#define SENSOR_MODEL_LUT_BYTES   %d    // Flash, float build\n\n", table_bytes);
+
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        printf("static const int16_t sensor_model_lut_thresholds_%d[SENSOR_MODEL_LUT_BINS_%d - 1] = {", f, f);
+        for (i = 0; i < n_thresholds[f]; i++) {
+            printf("%s%s%d", i ? "," : "", (i % 16) ? " " : "\n    ", thresholds[f][i]);
+        }
+        printf("\n};\n\n");
+    }
+
+    printf("// Distinct forest outputs\n");
+    printf("static const float sensor_model_lut_values[SENSOR_MODEL_LUT_VALUES] = {");
+    for (i = 0; i < n_values; i++) {
+        printf("%s%s%.9gf", i ? "," : "", (i % 6) ? " " : "\n    ", values[i]);
+    }
+    printf("\n};\n\n");
+
+    printf("#ifdef AQ_FIXED_POINT\n");
+    printf("static const aq_score_t sensor_model_lut_values_fx[SENSOR_MODEL_LUT_VALUES] = {");
+    for (i = 0; i < n_values; i++) {
+        printf("%s%s%ld", i ? "," : "", (i % 10) ? " " : "\n    ", (long)values_fx[i]);
+    }
+    printf("\n};\n#endif\n\n");
+
+    printf("// Value index of each cell, indexed [bin0][bin1][bin2]\n");
+    printf("static const %s sensor_model_lut_cells[%d] = {",
+           cell_bytes == 1 ? "uint8_t" : "uint16_t", n_cells);
+    for (i = 0; i < n_cells; i++) {
+        printf("%s%s%d", i ? "," : "", (i % 16) ? " " : "\n    ", cells[i]);
+    }
+    printf("\n};\n\n");
+
+    printf("%s",
+        "// Number of thresholds <= x, i.e. the bin x falls in\n"
+        "static inline int sensor_model_lut_bin(const int16_t *thr, int n, int16_t x) {\n"
+        "    const int16_t *base = thr;\n"
+        "\n"
+        "    while (n > 1) {\n"
+        "        int half = n / 2;\n"
+        "        base = (base[half] <= x) ? base + half : base;\n"
+        "        n -= half;\n"
+        "    }\n"
+        "    return (int)(base - thr) + (*base <= x);\n"
+        "}\n"
+        "\n"
+        "static inline int sensor_model_lut_cell(const int16_t *features) {\n"
+        "    int b0 = sensor_model_lut_bin(sensor_model_lut_thresholds_0, SENSOR_MODEL_LUT_BINS_0 - 1, features[0]);\n"
+        "    int b1 = sensor_model_lut_bin(sensor_model_lut_thresholds_1, SENSOR_MODEL_LUT_BINS_1 - 1, features[1]);\n"
+        "    int b2 = sensor_model_lut_bin(sensor_model_lut_thresholds_2, SENSOR_MODEL_LUT_BINS_2 - 1, features[2]);\n"
+        "\n"
+        "    return (b0 * SENSOR_MODEL_LUT_BINS_1 + b1) * SENSOR_MODEL_LUT_BINS_2 + b2;\n"
+        "}\n"
+        "\n"
+        "// Same contract as sensor_model_predict()\n"
+        "static inline float sensor_model_lut_predict(const int16_t *features, int32_t features_length) {\n"
+        "    (void)features_length;\n"
+        "    return sensor_model_lut_values[sensor_model_lut_cells[sensor_model_lut_cell(features)]];\n"
+        "}\n"
+        "\n"
+        "#ifdef AQ_FIXED_POINT\n"
+        "static inline aq_score_t sensor_model_lut_score(const int16_t *features) {\n"
+        "    return sensor_model_lut_values_fx[sensor_model_lut_cells[sensor_model_lut_cell(features)]];\n"
+        "}\n"
+        "#endif\n"
+        "\n"
+        "#endif // SENSOR_MODEL_LUT_H\n");
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * ==========================================================================
+ * sensor_model_memo.c - Incremental forest scoring between readings
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "sensor_model_memo.h"
+#include "sensor_model_lut.h"
+
+// Split thresholds of each feature, ascending
+static const int16_t *const memo_thresholds[SENSOR_MODEL_N_FEATURES] = {
+    sensor_model_lut_thresholds_0, sensor_model_lut_thresholds_1, sensor_model_lut_thresholds_2
+};
+static const uint8_t memo_n_thresholds[SENSOR_MODEL_N_FEATURES] = {
+    SENSOR_MODEL_LUT_BINS_0 - 1, SENSOR_MODEL_LUT_BINS_1 - 1, SENSOR_MODEL_LUT_BINS_2 - 1
+};
+
+// Walk one tree, recording which features its path tests
+static int memo_walk(int root, const int16_t *features, uint8_t *path_features) {
+    int idx = root;
+    uint8_t tested = 0;
+
+    while (idx >= 0) {
+        const struct sensor_model_node *n = &sensor_model_nodes[idx];
+        tested |= (uint8_t)(1 << n->feature);
+        idx = (features[n->feature] < n->threshold) ? n->left : n->right;
+    }
+    *path_features = tested;
+    return ~idx;
+}
+
+// Sum in tree order, exactly as the full model does
+static aq_score_t memo_sum(const struct sensor_model_memo *memo) {
+    int t;
+#ifdef AQ_FIXED_POINT
+    aq_score_t sum = 0;
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) sum += sensor_model_nodes_leaves_fx[memo->leaf[t]];
+    return (sum + SENSOR_MODEL_N_TREES / 2) / SENSOR_MODEL_N_TREES;
+#else
+    float avg = 0;
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) avg += sensor_model_nodes_leaves[memo->leaf[t]];
+    return avg / SENSOR_MODEL_N_TREES;
+#endif
+}
+
+void sensor_model_memo_reset(struct sensor_model_memo *memo) {
+    memset(memo, 0, sizeof(*memo));
+}
+
+aq_score_t sensor_model_memo_score(struct sensor_model_memo *memo, const int16_t *features) {
+    const int16_t *thr;
+    uint8_t changed = 0;
+    int f, t, n, b;
+
+    // Hit: two compares per feature. A reset memo has empty bins
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        if (features[f] < memo->lo[f] || features[f] >= memo->hi[f]) break;
+    }
+    if (f == SENSOR_MODEL_N_FEATURES) {
+        memo->hits++;
+        return memo->score;
+    }
+
+    // Only the features that left their bin are searched again
+    for (; f < SENSOR_MODEL_N_FEATURES; f++) {
+        if (features[f] >= memo->lo[f] && features[f] < memo->hi[f]) continue;
+        changed |= (uint8_t)(1 << f);
+        thr = memo_thresholds[f];
+        n = memo_n_thresholds[f];
+        b = sensor_model_lut_bin(thr, n, features[f]);
+        memo->lo[f] = b > 0 ? thr[b - 1] : INT16_MIN;
+        memo->hi[f] = b < n ? thr[b] : INT16_MAX + 1;
+    }
+
+    memo->misses++;
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        if (!memo->valid || (memo->path_features[t] & changed)) {
+            memo->leaf[t] = (uint8_t)memo_walk(sensor_model_nodes_roots[t], features,
+                                               &memo->path_features[t]);
+            memo->trees_evaluated++;
+        }
+    }
+    memo->score = memo_sum(memo);
+    memo->valid = 1;
+    return memo->score;
+}
@@ -0,0 +1,46 @@
+/*
+ * ==========================================================================
+ * sensor_model_memo.h - Incremental forest scoring between readings
+ * ==========================================================================
+ * Readings arrive once a second and rarely cross a split threshold. The
+ * memo keeps the bounds [lo, hi) of each feature's bin (the thresholds of
+ * sensor_model_lut.h around it), the leaf each tree ended in, and which
+ * features each tree's path tested.
+ *
+ * - Every feature still inside its bin: the cached score is returned
+ *   (hit), after two compares per feature.
+ * - Otherwise only the features that left their bin are binary-searched
+ *   for the new one, and only the trees whose path tests one of them are
+ *   walked again (miss); the others cannot have moved.
+ *
+ * Scores are bit-identical to a full evaluation (sensor_model_predict(),
+ * or sensor_model_nodes_score() under AQ_FIXED_POINT).
+ * ==========================================================================
+ */
+
+#ifndef SENSOR_MODEL_MEMO_H
+#define SENSOR_MODEL_MEMO_H
+
+#include <stdint.h>
+#include "aq_fixed.h"
+#include "sensor_model_nodes.h"
+
+struct sensor_model_memo {
+    int32_t lo[SENSOR_MODEL_N_FEATURES];          // Bin of the last reading: lo <= x < hi
+    int32_t hi[SENSOR_MODEL_N_FEATURES];
+    uint8_t leaf[SENSOR_MODEL_N_TREES];           // Leaf each tree ended in
+    uint8_t path_features[SENSOR_MODEL_N_TREES];  // Features tested on that path (bitmask)
+    aq_score_t score;                             // Cached forest score
+    int valid;
+
+    // Statistics
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t trees_evaluated;
+};
+
+void sensor_model_memo_reset(struct sensor_model_memo *memo);
+
+aq_score_t sensor_model_memo_score(struct sensor_model_memo *memo, const int16_t *features);
+
+#endif // SENSOR_MODEL_MEMO_H
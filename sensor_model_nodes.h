@@ -0,0 +1,202 @@
+/*
+ * ==========================================================================
+ * sensor_model_nodes.h - Flattened node-array form of the emlearn forest
+ * ==========================================================================
+ * !!! Generated by model_compiler.c - do not edit by hand !!!
+ *
+ * Same five trees as sensor_model.h, stored as data instead of nested if
+ * ladders, with unreachable tests and identical subtrees removed. Each
+ * internal node holds the feature it tests, the threshold, and its two
+ * children. A negative child is a leaf: ~child indexes
+ * sensor_model_nodes_leaves[] (deduplicated, as emlearn does for
+ * sensor_model_leaves[]).
+ *
+ * Every tree is evaluated by the same small loop, so a model update only
+ * changes the tables below, not the code.
+ *
+ * Footprint: 6 bytes per node + 4 bytes per leaf.
+ *
+ * With AQ_FIXED_POINT the leaves are also kept in fixed point and
+ * sensor_model_nodes_score() averages them in integers.
+ * ==========================================================================
+ */
+
+#ifndef SENSOR_MODEL_NODES_H
+#define SENSOR_MODEL_NODES_H
+
+#include <stdint.h>
+#include "aq_fixed.h"
+
+#define SENSOR_MODEL_N_FEATURES  3
+#define SENSOR_MODEL_N_TREES     5
+#define SENSOR_MODEL_N_NODES     73
+#define SENSOR_MODEL_N_LEAVES    77
+#define SENSOR_MODEL_MAX_DEPTH   4       // Compares on the longest path
+#define SENSOR_MODEL_NODES_BYTES 751     // Flash: nodes, roots, float leaves
+
+struct sensor_model_node {
+    int8_t  feature;     // Feature index tested by this node
+    int16_t threshold;   // Go left when features[feature] < threshold
+    int8_t  left;        // Child node index, or ~leaf index when negative
+    int8_t  right;
+};
+
+static const struct sensor_model_node sensor_model_nodes[SENSOR_MODEL_N_NODES] = {
+    // Tree 0
+    { 0,  41,    1,    8 },
+    { 0,  28,    2,    5 },
+    { 0,  23,    3,    4 },
+    { 0,  18,   -1,   -2 },
+    { 1,  29,   -3,   -4 },
+    { 0,  36,    6,    7 },
+    { 2,  75,   -5,   -6 },
+    { 1,  32,   -7,   -8 },
+    { 0,  53,    9,   12 },
+    { 1,  34,   10,   11 },
+    { 1,  31,   -9,  -10 },
+    { 0,  45,  -11,  -12 },
+    { 1,  34,   13,  -15 },
+    { 0,  71,  -13,  -14 },
+    // Tree 1
+    { 0,  40,   15,   22 },
+    { 0,  27,   16,   19 },
+    { 0,  21,   17,   18 },
+    { 1,  31,  -16,  -17 },
+    { 1,  31,  -18,  -19 },
+    { 0,  33,   20,   21 },
+    { 2,  81,  -20,  -21 },
+    { 1,  32,  -22,  -23 },
+    { 0,  60,   23,   26 },
+    { 1,  33,   24,   25 },
+    { 0,  44,  -24,  -25 },
+    { 1,  35,  -26,  -27 },
+    { 1,  32,  -28,   27 },
+    { 1,  35,  -29,  -30 },
+    // Tree 2
+    { 0,  40,   29,   36 },
+    { 0,  27,   30,   33 },
+    { 0,  20,   31,   32 },
+    { 1,  31,  -31,  -32 },
+    { 1,  30,  -33,  -34 },
+    { 0,  33,   34,   35 },
+    { 1,  29,  -35,  -36 },
+    { 2,  86,  -37,  -38 },
+    { 0,  59,   37,   40 },
+    { 1,  34,   38,   39 },
+    { 0,  49,  -39,  -40 },
+    { 1,  35,  -41,  -42 },
+    { 1,  34,   41,   42 },
+    { 1,  32,  -28,  -43 },
+    { 1,  35,  -44,  -45 },
+    // Tree 3
+    { 0,  37,   44,   51 },
+    { 0,  27,   45,   48 },
+    { 0,  20,   46,   47 },
+    { 1,  30,  -46,  -47 },
+    { 1,  31,  -48,  -49 },
+    { 0,  31,   49,   50 },
+    { 1,  30,  -50,  -51 },
+    { 2,  88,  -52,  -53 },
+    { 0,  54,   52,   55 },
+    { 1,  34,   53,   54 },
+    { 1,  31,  -54,  -55 },
+    { 0,  45,  -56,  -57 },
+    { 1,  34,   56,   57 },
+    { 2,  87,  -58,  -59 },
+    { 0,  60,  -60,  -61 },
+    // Tree 4
+    { 0,  38,   59,   66 },
+    { 0,  27,   60,   63 },
+    { 0,  21,   61,   62 },
+    { 1,  30,  -62,  -63 },
+    { 0,  25,  -64,  -65 },
+    { 0,  31,   64,   65 },
+    { 2,  77,  -66,  -67 },
+    { 0,  36,  -68,  -69 },
+    { 0,  54,   67,   70 },
+    { 1,  31,   68,   69 },
+    { 0,  44,  -70,  -71 },
+    { 1,  34,  -72,  -73 },
+    { 1,  33,   71,   72 },
+    { 2,  83,  -74,  -75 },
+    { 1,  34,  -76,  -77 }
+};
+
+static const int8_t sensor_model_nodes_roots[SENSOR_MODEL_N_TREES] = { 0, 14, 28, 43, 58 };
+
+static const float sensor_model_nodes_leaves[SENSOR_MODEL_N_LEAVES] = {
+    62.213333f, 78.072990f, 88.875000f, 116.644447f, 140.096771f, 171.362839f,
+    200.623184f, 255.333328f, 232.440002f, 276.827271f, 310.000000f, 349.399994f,
+    341.566040f, 424.625000f, 445.538452f, 67.715187f, 98.833336f, 89.488190f,
+    168.000000f, 147.833328f, 177.866669f, 194.232330f, 257.500000f, 240.127655f,
+    284.685394f, 329.716980f, 407.333344f, 295.000000f, 419.019989f, 460.538452f,
+    64.705132f, 107.750000f, 86.390244f, 110.677422f, 118.000000f, 158.646347f,
+    188.046722f, 229.176468f, 258.877563f, 306.375000f, 349.294128f, 439.750000f,
+    411.945953f, 444.037048f, 480.000000f, 64.593750f, 87.636368f, 88.655998f,
+    116.111115f, 130.589737f, 163.689651f, 181.964905f, 221.153839f, 213.928574f,
+    270.686127f, 299.500000f, 362.750000f, 319.500000f, 381.575745f, 393.863647f,
+    442.235291f, 64.111885f, 82.937500f, 88.255104f, 115.233330f, 120.800003f,
+    160.722229f, 180.733337f, 212.034485f, 201.611115f, 242.000000f, 268.842865f,
+    346.333344f, 284.777771f, 349.714294f, 400.632660f, 446.506836f
+};
+
+#ifdef AQ_FIXED_POINT
+static const aq_score_t sensor_model_nodes_leaves_fx[SENSOR_MODEL_N_LEAVES] = {
+    AQ_SCORE(62.213333), AQ_SCORE(78.072990), AQ_SCORE(88.875000), AQ_SCORE(116.644447), AQ_SCORE(140.096771),
+    AQ_SCORE(171.362839), AQ_SCORE(200.623184), AQ_SCORE(255.333328), AQ_SCORE(232.440002), AQ_SCORE(276.827271),
+    AQ_SCORE(310.000000), AQ_SCORE(349.399994), AQ_SCORE(341.566040), AQ_SCORE(424.625000), AQ_SCORE(445.538452),
+    AQ_SCORE(67.715187), AQ_SCORE(98.833336), AQ_SCORE(89.488190), AQ_SCORE(168.000000), AQ_SCORE(147.833328),
+    AQ_SCORE(177.866669), AQ_SCORE(194.232330), AQ_SCORE(257.500000), AQ_SCORE(240.127655), AQ_SCORE(284.685394),
+    AQ_SCORE(329.716980), AQ_SCORE(407.333344), AQ_SCORE(295.000000), AQ_SCORE(419.019989), AQ_SCORE(460.538452),
+    AQ_SCORE(64.705132), AQ_SCORE(107.750000), AQ_SCORE(86.390244), AQ_SCORE(110.677422), AQ_SCORE(118.000000),
+    AQ_SCORE(158.646347), AQ_SCORE(188.046722), AQ_SCORE(229.176468), AQ_SCORE(258.877563), AQ_SCORE(306.375000),
+    AQ_SCORE(349.294128), AQ_SCORE(439.750000), AQ_SCORE(411.945953), AQ_SCORE(444.037048), AQ_SCORE(480.000000),
+    AQ_SCORE(64.593750), AQ_SCORE(87.636368), AQ_SCORE(88.655998), AQ_SCORE(116.111115), AQ_SCORE(130.589737),
+    AQ_SCORE(163.689651), AQ_SCORE(181.964905), AQ_SCORE(221.153839), AQ_SCORE(213.928574), AQ_SCORE(270.686127),
+    AQ_SCORE(299.500000), AQ_SCORE(362.750000), AQ_SCORE(319.500000), AQ_SCORE(381.575745), AQ_SCORE(393.863647),
+    AQ_SCORE(442.235291), AQ_SCORE(64.111885), AQ_SCORE(82.937500), AQ_SCORE(88.255104), AQ_SCORE(115.233330),
+    AQ_SCORE(120.800003), AQ_SCORE(160.722229), AQ_SCORE(180.733337), AQ_SCORE(212.034485), AQ_SCORE(201.611115),
+    AQ_SCORE(242.000000), AQ_SCORE(268.842865), AQ_SCORE(346.333344), AQ_SCORE(284.777771), AQ_SCORE(349.714294),
+    AQ_SCORE(400.632660), AQ_SCORE(446.506836)
+};
+#endif
+
+// Walk one tree from its root and return the index of the leaf reached
+static inline int sensor_model_nodes_leaf(int root, const int16_t *features) {
+    int idx = root;
+
+    while (idx >= 0) {
+        const struct sensor_model_node *n = &sensor_model_nodes[idx];
+        idx = (features[n->feature] < n->threshold) ? n->left : n->right;
+    }
+    return ~idx;
+}
+
+// Drop-in replacement for sensor_model_predict()
+static inline float sensor_model_nodes_predict(const int16_t *features, int32_t features_length) {
+    float avg = 0;
+    int t;
+
+    (void)features_length;
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        avg += sensor_model_nodes_leaves[sensor_model_nodes_leaf(sensor_model_nodes_roots[t], features)];
+    }
+    return avg / SENSOR_MODEL_N_TREES;
+}
+
+// Forest average as an aq_score_t (float, or fixed point with AQ_FIXED_POINT)
+static inline aq_score_t sensor_model_nodes_score(const int16_t *features) {
+#ifdef AQ_FIXED_POINT
+    aq_score_t sum = 0;
+    int t;
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        sum += sensor_model_nodes_leaves_fx[sensor_model_nodes_leaf(sensor_model_nodes_roots[t], features)];
+    }
+    return (sum + SENSOR_MODEL_N_TREES / 2) / SENSOR_MODEL_N_TREES;
+#else
+    return sensor_model_nodes_predict(features, SENSOR_MODEL_N_FEATURES);
+#endif
+}
+
+#endif // SENSOR_MODEL_NODES_H
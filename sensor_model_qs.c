@@ -0,0 +1,159 @@
+/*
+ * ==========================================================================
+ * sensor_model_qs.c - QuickScorer-style bitvector evaluation of the forest
+ * ==========================================================================
+ */
+
+#include <string.h>
+#include "sensor_model_qs.h"
+
+// One bit per leaf, so a tree may have at most 32 leaves
+#define QS_MAX_LEAVES 32
+
+#if defined(__CC_ARM)
+#define QS_CTZ(x) __clz(__rbit(x))
+#else
+#define QS_CTZ(x) __builtin_ctz(x)
+#endif
+
+// Distinct thresholds of each feature, ascending:
+// qs_thresholds[qs_thr_start[f] .. qs_thr_start[f + 1] - 1]
+static int16_t qs_thresholds[SENSOR_MODEL_N_NODES];
+static uint8_t qs_thr_start[SENSOR_MODEL_N_FEATURES + 1];
+
+// Row qs_thr_start[f] + f + p holds, per tree, the AND of the false-node
+// masks of every feature f test whose threshold is among the p smallest
+static uint32_t qs_masks[SENSOR_MODEL_N_NODES + SENSOR_MODEL_N_FEATURES][SENSOR_MODEL_N_TREES];
+
+// Leaf table index of each tree's leaves, left to right
+static uint8_t qs_leaf[SENSOR_MODEL_N_TREES][QS_MAX_LEAVES];
+
+// Mask that clears the leaves of each node's left subtree
+static uint32_t qs_node_mask[SENSOR_MODEL_N_NODES];
+
+// Number leaves left to right and record each node's left-subtree mask
+static int qs_number_leaves(int tree, int child, int next_leaf) {
+    const struct sensor_model_node *n;
+    int first;
+
+    if (child < 0) {
+        qs_leaf[tree][next_leaf] = (uint8_t)~child;
+        return next_leaf + 1;
+    }
+    n = &sensor_model_nodes[child];
+    first = next_leaf;
+    next_leaf = qs_number_leaves(tree, n->left, next_leaf);
+    qs_node_mask[child] = ~((uint32_t)((1ULL << next_leaf) - (1ULL << first)));
+    return qs_number_leaves(tree, n->right, next_leaf);
+}
+
+void sensor_model_qs_init(void) {
+    int t, f, i, j, p, count;
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+        qs_number_leaves(t, sensor_model_nodes_roots[t], 0);
+    }
+
+    // Distinct thresholds per feature, insertion-sorted
+    count = 0;
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        qs_thr_start[f] = (uint8_t)count;
+        for (i = 0; i < SENSOR_MODEL_N_NODES; i++) {
+            int16_t thr = sensor_model_nodes[i].threshold;
+
+            if (sensor_model_nodes[i].feature != f) continue;
+            for (j = qs_thr_start[f]; j < count && qs_thresholds[j] < thr; j++);
+            if (j < count && qs_thresholds[j] == thr) continue;
+            memmove(&qs_thresholds[j + 1], &qs_thresholds[j], (count - j) * sizeof(qs_thresholds[0]));
+            qs_thresholds[j] = thr;
+            count++;
+        }
+    }
+    qs_thr_start[SENSOR_MODEL_N_FEATURES] = (uint8_t)count;
+
+    // Prefix-AND the node masks along each feature's sorted thresholds
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        int start = qs_thr_start[f];
+        int n_thr = qs_thr_start[f + 1] - start;
+        uint32_t (*rows)[SENSOR_MODEL_N_TREES] = &qs_masks[start + f];
+
+        for (t = 0; t < SENSOR_MODEL_N_TREES; t++) rows[0][t] = ~0u;
+        for (p = 1; p <= n_thr; p++) {
+            for (t = 0; t < SENSOR_MODEL_N_TREES; t++) rows[p][t] = rows[p - 1][t];
+            for (t = 0; t < SENSOR_MODEL_N_TREES; t++) {
+                int end = (t + 1 < SENSOR_MODEL_N_TREES) ? sensor_model_nodes_roots[t + 1]
+                                                        : SENSOR_MODEL_N_NODES;
+                for (i = sensor_model_nodes_roots[t]; i < end; i++) {
+                    if (sensor_model_nodes[i].feature == f &&
+                        sensor_model_nodes[i].threshold == qs_thresholds[start + p - 1]) {
+                        rows[p][t] &= qs_node_mask[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Every trained forest has at least one threshold
+int sensor_model_qs_ready(void) {
+    return qs_thr_start[SENSOR_MODEL_N_FEATURES] != 0;
+}
+
+// Number of thresholds <= x, by a binary search whose step count depends
+// only on the table length
+static inline int qs_count_le(const int16_t *thr, int n, int16_t x) {
+    const int16_t *base = thr;
+
+    if (n == 0) return 0;
+    while (n > 1) {
+        int half = n / 2;
+        base = (base[half] <= x) ? base + half : base;
+        n -= half;
+    }
+    return (int)(base - thr) + (*base <= x);
+}
+
+// Exit leaf (leaf table index) of every tree
+static void qs_exit_leaves(const int16_t *features, uint8_t *exit_leaf) {
+    uint32_t leaves[SENSOR_MODEL_N_TREES];
+    int t, f;
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) leaves[t] = ~0u;
+
+    for (f = 0; f < SENSOR_MODEL_N_FEATURES; f++) {
+        int start = qs_thr_start[f];
+        int p = qs_count_le(&qs_thresholds[start], qs_thr_start[f + 1] - start, features[f]);
+        const uint32_t *row = qs_masks[start + f + p];
+
+        for (t = 0; t < SENSOR_MODEL_N_TREES; t++) leaves[t] &= row[t];
+    }
+
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) exit_leaf[t] = qs_leaf[t][QS_CTZ(leaves[t])];
+}
+
+#ifndef AQ_FIXED_POINT
+float sensor_model_qs_predict(const int16_t *features, int32_t features_length) {
+    uint8_t exit_leaf[SENSOR_MODEL_N_TREES];
+    float avg = 0;
+    int t;
+
+    (void)features_length;
+    qs_exit_leaves(features, exit_leaf);
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) avg += sensor_model_nodes_leaves[exit_leaf[t]];
+    return avg / SENSOR_MODEL_N_TREES;
+}
+#endif
+
+aq_score_t sensor_model_qs_score(const int16_t *features) {
+#ifdef AQ_FIXED_POINT
+    uint8_t exit_leaf[SENSOR_MODEL_N_TREES];
+    aq_score_t sum = 0;
+    int t;
+
+    qs_exit_leaves(features, exit_leaf);
+    for (t = 0; t < SENSOR_MODEL_N_TREES; t++) sum += sensor_model_nodes_leaves_fx[exit_leaf[t]];
+    return (sum + SENSOR_MODEL_N_TREES / 2) / SENSOR_MODEL_N_TREES;
+#else
+    return sensor_model_qs_predict(features, SENSOR_MODEL_N_FEATURES);
+#endif
+}
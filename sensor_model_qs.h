@@ -0,0 +1,40 @@
+/*
+ * ==========================================================================
+ * sensor_model_qs.h - QuickScorer-style bitvector evaluation of the forest
+ * ==========================================================================
+ * Each tree keeps a bitvector with one bit per leaf (left to right). Every
+ * node whose test is false for the current sample clears the leaves of its
+ * left subtree, and the exit leaf is the lowest bit still set.
+ *
+ * sensor_model_qs_init() sorts the distinct thresholds of each feature
+ * once and folds all node masks into one row of per-tree masks for every
+ * possible "number of thresholds <= x". Scoring a sample is then one
+ * fixed-length binary search per feature, one AND per tree and feature,
+ * and a count-trailing-zeros per tree: constant time, no data-dependent
+ * branches.
+ *
+ * Results are bit-identical to sensor_model_predict().
+ * ==========================================================================
+ */
+
+#ifndef SENSOR_MODEL_QS_H
+#define SENSOR_MODEL_QS_H
+
+#include <stdint.h>
+#include "sensor_model_nodes.h"
+
+// Build the sorted threshold and mask tables (call once at start-up)
+void sensor_model_qs_init(void);
+
+// Nonzero once sensor_model_qs_init() has run
+int sensor_model_qs_ready(void);
+
+#ifndef AQ_FIXED_POINT
+// Same contract as sensor_model_predict() (float builds only)
+float sensor_model_qs_predict(const int16_t *features, int32_t features_length);
+#endif
+
+// Forest average as an aq_score_t, like sensor_model_nodes_score()
+aq_score_t sensor_model_qs_score(const int16_t *features);
+
+#endif // SENSOR_MODEL_QS_H